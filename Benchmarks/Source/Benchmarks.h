@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    Benchmarks.h
+    Command-line benchmarks for the chorus DSP.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+// Each benchmark prints its results to stdout and returns 0, or prints why it
+// couldn't run and returns 1. Build the Release configuration: the numbers are
+// meaningless without optimisation.
+int runCounterBenchmark();
+int runInstanceBenchmark();
+int runLfoBenchmark();
+int runOverheadBenchmark();
+int runWorstCaseBenchmark();
+
+// steady clock, in nanoseconds
+inline int64_t benchNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// keeps the compiler from dropping work whose results nothing reads
+inline void benchKeep(double value)
+{
+    static volatile double sink;
+    sink = value;
+    (void) sink;
+}
+
+// parameter indices, in getParameters() order
+enum BenchParam { benchDepth, benchRate, benchFocus, benchWet, benchDry, benchStereo, benchDelay };
+
+// sets a processor parameter in its own units, as host automation would
+inline void benchSetParameter(juce::AudioProcessor& processor, int index, float value)
+{
+    if (auto* param = dynamic_cast<juce::AudioParameterFloat*>(processor.getParameters()[index]))
+        *param = value;
+}
+
+// fills both channels with a bright, nonperiodic test signal
+inline void benchFillInput(juce::AudioBuffer<float>& buffer)
+{
+    for (int ch = 0; ch < buffer.getNumChannels(); ch++) {
+        float* data = buffer.getWritePointer(ch);
+        for (int i = 0; i < buffer.getNumSamples(); i++)
+            data[i] = 0.5f*std::sin(0.05f*(ch + 1)*i) + 0.1f*(float) ((i*7919 + ch) % 101 - 50)/50;
+    }
+}
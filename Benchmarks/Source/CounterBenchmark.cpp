@@ -0,0 +1,216 @@
+/*
+  ==============================================================================
+
+    CounterBenchmark.cpp
+    Hardware counters per sample for the DSP kernels and the whole processBlock.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "PerfCounters.h"
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/StkLite-4.6.1/BiQuad.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const double pi = 3.14159265358979323846;
+const double fs = 48000;
+const int blockSize = STAGE_BLOCK_SIZE;
+const int numBlocks = 20000;
+const int modulationBlocks = 96; // delay modulation precomputed for this many blocks, then repeated
+
+struct Measurement {
+    double nanos;
+    double counts[PerfCounters::NUM_COUNTERS];
+};
+
+// smallest count each counter gives for a read pair with nothing between
+Measurement emptyPair(const PerfCounters& counters)
+{
+    Measurement empty;
+    empty.nanos = 0;
+    for (int c = 0; c < PerfCounters::NUM_COUNTERS; c++)
+        empty.counts[c] = 1e30;
+    for (int i = 0; i < 1000; i++) {
+        uint64_t start[PerfCounters::NUM_COUNTERS], end[PerfCounters::NUM_COUNTERS];
+        counters.read(start);
+        counters.read(end);
+        for (int c = 0; c < PerfCounters::NUM_COUNTERS; c++)
+            empty.counts[c] = std::min(empty.counts[c], (double) (end[c] - start[c]));
+    }
+    return empty;
+}
+
+// Runs block numBlocks times between one pair of counter reads and gives the
+// counts per stereo sample, less an empty pair's. Each kernel is measured on
+// its own, so no measurement has another's reads inside it.
+template <typename Block>
+Measurement measure(const PerfCounters& counters, const Measurement& empty, Block block)
+{
+    for (int b = 0; b < 100; b++) // warm up caches and predictors
+        block(b);
+
+    uint64_t start[PerfCounters::NUM_COUNTERS], end[PerfCounters::NUM_COUNTERS];
+    int64_t startNanos = benchNanos();
+    counters.read(start);
+    for (int b = 0; b < numBlocks; b++)
+        block(b);
+    counters.read(end);
+    int64_t endNanos = benchNanos();
+
+    const double numSamples = (double) numBlocks*blockSize;
+    Measurement m;
+    m.nanos = (endNanos - startNanos)/numSamples;
+    for (int c = 0; c < PerfCounters::NUM_COUNTERS; c++)
+        m.counts[c] = std::max(0.0, end[c] - start[c] - empty.counts[c])/numSamples;
+    return m;
+}
+
+// Per-sample delays as the processor computes them, for an LFO at rate Hz
+// sweeping depthMs around delayMs, precomputed so the loop only runs DelayA
+std::vector<stk::StkFloat> modulatedDelays(double rate, double depthPercent, double delayMs, double phase)
+{
+    double delay = std::ceil(delayMs*fs/1000);
+    double depth = std::ceil((delayMs - INST_DELAY_MIN)*depthPercent/100*fs/1000);
+    std::vector<stk::StkFloat> delays((size_t) modulationBlocks*blockSize);
+    for (size_t i = 0; i < delays.size(); i++)
+        delays[i] = delay + depth*std::sin(2*pi*rate*i/fs + phase);
+    return delays;
+}
+
+struct DelayKernel {
+    stk::DelayA left { 0.5, 1 }, right { 0.5, 1 };
+    std::vector<stk::StkFloat> leftDelays, rightDelays;
+    float in[2][blockSize], out[2][blockSize];
+
+    DelayKernel(double rate, double depthPercent, double delayMs)
+    {
+        stk::Stk::StkFormat format = DELAY_HISTORY_BITS == 32 ? stk::Stk::STK_FLOAT32
+                                   : DELAY_HISTORY_BITS == 16 ? stk::Stk::STK_SINT16 : stk::Stk::STK_FLOAT64;
+        unsigned long maxDelay = (unsigned long) std::ceil(MAX_TOTAL_DELAY*(MAX_SAMPLE_RATE/1000.0));
+        for (stk::DelayA* line : { &left, &right }) {
+            line->setStorageFormat(format);
+            line->setMaximumDelay(maxDelay);
+        }
+        leftDelays = modulatedDelays(rate, depthPercent, delayMs, STEREO_DEFAULT*pi/180);
+        rightDelays = modulatedDelays(rate, depthPercent, delayMs, -STEREO_DEFAULT*pi/180);
+        for (int i = 0; i < blockSize; i++) {
+            in[0][i] = 0.5f*std::sin(0.05f*i);
+            in[1][i] = 0.5f*std::cos(0.03f*i);
+        }
+    }
+
+    void operator()(int block)
+    {
+        size_t offset = (size_t) (block % modulationBlocks)*blockSize;
+        left.tick(in[0], out[0], &leftDelays[offset], blockSize);
+        right.tick(in[1], out[1], &rightDelays[offset], blockSize);
+        benchKeep(out[0][0] + out[1][blockSize - 1]);
+    }
+};
+
+}
+
+int runCounterBenchmark()
+{
+    PerfCounters counters;
+    Measurement empty = emptyPair(counters);
+
+    // the LFO pair the processor runs when LFO_QUADRATURE is 0
+    Mu45LFO leftLFO, rightLFO;
+    float leftMod[blockSize], rightMod[blockSize];
+    for (Mu45LFO* lfo : { &leftLFO, &rightLFO }) {
+        lfo->setFixedPoint(LFO_FIXED_POINT != 0);
+        lfo->setFreq(RATE_DEFAULT, (float) fs);
+    }
+    leftLFO.setPhaseOffset(STEREO_DEFAULT);
+    rightLFO.setPhaseOffset(-STEREO_DEFAULT);
+
+    DelayKernel delayDefault(RATE_DEFAULT, DEPTH_DEFAULT, DELAY_DEFAULT);
+    DelayKernel delayMax(RATE_MAX, DEPTH_MAX, DELAY_MAX);
+
+    // STK's biquad as a 200 Hz, Q 1 high pass (RBJ cookbook), against the SVF the processor uses
+    stk::BiQuad leftBiQuad, rightBiQuad;
+    double w = 2*pi*200/fs, alpha = std::sin(w)/2, a0 = 1 + alpha;
+    for (stk::BiQuad* biquad : { &leftBiQuad, &rightBiQuad })
+        biquad->setCoefficients((1 + std::cos(w))/2/a0, -(1 + std::cos(w))/a0, (1 + std::cos(w))/2/a0,
+                                -2*std::cos(w)/a0, (1 - alpha)/a0);
+    stk::SVF svf; // both channels at once, as the processor runs it
+    svf.setSampleRate(fs);
+    svf.setMode(stk::SVF::HIGHPASS);
+    svf.setQ(1);
+    svf.setFrequency(200);
+    float filterIn[2][blockSize], filterOut[2][blockSize];
+    for (int i = 0; i < blockSize; i++) {
+        filterIn[0][i] = 0.5f*std::sin(0.05f*i);
+        filterIn[1][i] = 0.5f*std::cos(0.03f*i);
+    }
+
+    ColemanJP04ChorusAudioProcessor processor;
+    processor.prepareToPlay(fs, blockSize);
+    juce::AudioBuffer<float> input(2, blockSize), buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    benchFillInput(input);
+
+    static const int numRows = 7;
+    const char* names[numRows] = {
+        "Mu45LFO", "DelayA", "DelayA (max)", "BiQuad", "SVF", "processBlock", "processBlock (max)"
+    };
+    Measurement rows[numRows];
+    rows[0] = measure(counters, empty, [&] (int) {
+        leftLFO.tick(leftMod, blockSize);
+        rightLFO.tick(rightMod, blockSize);
+        benchKeep(leftMod[0] + rightMod[blockSize - 1]);
+    });
+    rows[1] = measure(counters, empty, [&] (int b) { delayDefault(b); });
+    rows[2] = measure(counters, empty, [&] (int b) { delayMax(b); });
+    rows[3] = measure(counters, empty, [&] (int) {
+        for (int i = 0; i < blockSize; i++) {
+            filterOut[0][i] = (float) leftBiQuad.tick(filterIn[0][i]);
+            filterOut[1][i] = (float) rightBiQuad.tick(filterIn[1][i]);
+        }
+        benchKeep(filterOut[0][0] + filterOut[1][blockSize - 1]);
+    });
+    rows[4] = measure(counters, empty, [&] (int) {
+        std::memcpy(filterOut, filterIn, sizeof(filterOut)); // filtered in place
+        svf.tickChannels(filterOut[0], filterOut[1], blockSize);
+        benchKeep(filterOut[0][0] + filterOut[1][blockSize - 1]);
+    });
+    auto processBlock = [&] (int) {
+        for (int ch = 0; ch < 2; ch++)
+            std::memcpy(buffer.getWritePointer(ch), input.getReadPointer(ch), blockSize*sizeof(float));
+        processor.processBlock(buffer, midi);
+        benchKeep(buffer.getReadPointer(0)[0]);
+    };
+    rows[5] = measure(counters, empty, processBlock);
+    benchSetParameter(processor, benchDepth, DEPTH_MAX);
+    benchSetParameter(processor, benchRate, RATE_MAX);
+    benchSetParameter(processor, benchDelay, DELAY_MAX);
+    rows[6] = measure(counters, empty, processBlock);
+
+    std::printf("per stereo sample, %d blocks of %d at %g Hz; \"max\" is max depth, rate and delay\n",
+                numBlocks, blockSize, fs);
+    std::printf("%-20s %8s", "", "ns");
+    for (int c = 0; c < PerfCounters::NUM_COUNTERS; c++)
+        if (counters.has((PerfCounters::Counter) c))
+            std::printf(" %14s", PerfCounters::name((PerfCounters::Counter) c));
+    std::printf("\n");
+    for (int r = 0; r < numRows; r++) {
+        std::printf("%-20s %8.2f", names[r], rows[r].nanos);
+        for (int c = 0; c < PerfCounters::NUM_COUNTERS; c++)
+            if (counters.has((PerfCounters::Counter) c))
+                std::printf(" %14.4f", rows[r].counts[c]);
+        std::printf("\n");
+    }
+    std::printf("(processBlock includes copying in the input block, as its output overwrote it)\n");
+    if (! counters.any())
+        std::printf("no hardware counters could be opened (not Linux, a VM without a PMU, or "
+                    "/proc/sys/kernel/perf_event_paranoid above 2), so only times are shown\n");
+    return 0;
+}
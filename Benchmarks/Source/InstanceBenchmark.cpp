@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    InstanceBenchmark.cpp
+    Creating, preparing and destroying many plugin instances, as a host does
+    when it loads a large session.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "../../Source/PluginProcessor.h"
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace {
+
+const int numInstances = 1000;
+const double fs = 48000;
+const int blockSize = 256;
+
+struct Result {
+    double construct = 1e30, prepare = 1e30, destroy = 1e30; // ms for all instances
+    size_t bytesBefore = 0, bytesAfter = 0; // footprint of all instances
+};
+
+}
+
+int runInstanceBenchmark()
+{
+    Result result;
+    for (int run = 0; run < 7; run++) {
+        std::vector<std::unique_ptr<ColemanJP04ChorusAudioProcessor>> instances;
+        instances.reserve(numInstances);
+
+        int64_t start = benchNanos();
+        for (int i = 0; i < numInstances; i++)
+            instances.emplace_back(new ColemanJP04ChorusAudioProcessor());
+        int64_t constructed = benchNanos();
+
+        size_t bytesBefore = 0;
+        for (auto& instance : instances)
+            bytesBefore += instance->getMemoryFootprint();
+
+        int64_t prepareStart = benchNanos();
+        for (auto& instance : instances)
+            instance->prepareToPlay(fs, blockSize);
+        int64_t prepared = benchNanos();
+
+        size_t bytesAfter = 0;
+        for (auto& instance : instances)
+            bytesAfter += instance->getMemoryFootprint();
+
+        int64_t destroyStart = benchNanos();
+        instances.clear();
+        int64_t destroyed = benchNanos();
+
+        result.construct = std::fmin(result.construct, (constructed - start)*1e-6);
+        result.prepare = std::fmin(result.prepare, (prepared - prepareStart)*1e-6);
+        result.destroy = std::fmin(result.destroy, (destroyed - destroyStart)*1e-6);
+        result.bytesBefore = bytesBefore;
+        result.bytesAfter = bytesAfter;
+    }
+
+    std::printf("%d instances, prepared at %g Hz, best of 7 runs\n", numInstances, fs);
+    std::printf("%-28s %12s %18s\n", "", "all, ms", "per instance, us");
+    std::printf("%-28s %12.2f %18.2f\n", "construct", result.construct, result.construct*1000/numInstances);
+    std::printf("%-28s %12.2f %18.2f\n", "prepareToPlay", result.prepare, result.prepare*1000/numInstances);
+    std::printf("%-28s %12.2f %18.2f\n", "destroy", result.destroy, result.destroy*1000/numInstances);
+    std::printf("\n%-28s %12s %18s\n", "footprint", "all, MB", "per instance, kB");
+    std::printf("%-28s %12.2f %18.2f\n", "before prepareToPlay",
+                result.bytesBefore/1048576.0, result.bytesBefore/1024.0/numInstances);
+    std::printf("%-28s %12.2f %18.2f\n", "after prepareToPlay",
+                result.bytesAfter/1048576.0, result.bytesAfter/1024.0/numInstances);
+    std::printf("(footprint counts the processor and its DSP buffers, not JUCE's own allocations)\n");
+    
+    ColemanJP04ChorusAudioProcessor probe;
+    std::printf("(the %d-program bank is read once per process, by the first instance to use it, and shared; "
+                "construction reads no files)\n", probe.getNumPrograms());
+    return 0;
+}
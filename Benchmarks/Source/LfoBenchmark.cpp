@@ -0,0 +1,181 @@
+/*
+  ==============================================================================
+
+    LfoBenchmark.cpp
+    Mu45LFO (wavetable) against Mu45QuadLFO (quadrature rotator).
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "../../Source/Defines.h"
+#include "../../Source/Mu45LFO/Mu45LFO.h"
+#include "../../Source/Mu45LFO/Mu45QuadLFO.h"
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+const double twoPi = 6.283185307179586476925286766559;
+const float fs = 48000;
+const float stereo = STEREO_DEFAULT;
+
+// The pair of wavetable LFOs the processor runs when LFO_QUADRATURE is 0
+struct TablePair {
+    Mu45LFO left, right;
+    TablePair(bool fixedPoint, float freq)
+    {
+        left.setFixedPoint(fixedPoint);
+        right.setFixedPoint(fixedPoint);
+        update(freq);
+    }
+    void update(float freq)
+    {
+        left.setFreq(freq, fs);
+        right.setFreq(freq, fs);
+        left.setPhaseOffset(stereo);
+        right.setPhaseOffset(-stereo);
+    }
+};
+
+struct Errors {
+    double table = 0, tableFloat = 0, quad = 0;
+};
+
+// Largest output error over minutes of running, each LFO against the exact sine
+// at the rate it actually runs: the fixed-point table's increment is rounded to
+// 2^-32 cycles and the float table's to a float, which is no error in the waveform.
+Errors measureAccuracy(float freq, double minutes)
+{
+    TablePair table(true, freq), tableFloat(false, freq);
+    Mu45QuadLFO quad;
+    quad.setFreq(freq, fs);
+    quad.setPhaseOffset(stereo);
+
+    double fixedRate = std::floor((double) freq/fs*4294967296.0 + 0.5)/4294967296.0;
+    double floatRate = (double) (1024*freq/fs)/1024;
+    double quadRate = (double) freq/fs;
+    double offset = stereo/360.0;
+
+    Errors errors;
+    long numSamples = (long) (minutes*60*fs);
+    for (long n = 0; n < numSamples; n++) {
+        float q1, q2;
+        quad.tick(q1, q2);
+        float t1 = table.left.tick(), t2 = table.right.tick();
+        float f1 = tableFloat.left.tick(), f2 = tableFloat.right.tick();
+
+        double p = std::fmod(fixedRate*n, 1.0);
+        errors.table = std::fmax(errors.table, std::fmax(std::fabs(t1 - std::sin(twoPi*(p + offset))),
+                                                         std::fabs(t2 - std::sin(twoPi*(p - offset)))));
+        p = std::fmod(floatRate*n, 1.0);
+        errors.tableFloat = std::fmax(errors.tableFloat, std::fmax(std::fabs(f1 - std::sin(twoPi*(p + offset))),
+                                                                   std::fabs(f2 - std::sin(twoPi*(p - offset)))));
+        p = std::fmod(quadRate*n, 1.0);
+        errors.quad = std::fmax(errors.quad, std::fmax(std::fabs(q1 - std::sin(twoPi*(p + offset))),
+                                                       std::fabs(q2 - std::sin(twoPi*(p - offset)))));
+    }
+    return errors;
+}
+
+// best of several runs of fn, which processes samplesPerRun stereo samples, in ns per sample
+template <typename Fn>
+double nanosPerSample(Fn fn, double samplesPerRun)
+{
+    double best = 1e30;
+    for (int run = 0; run < 7; run++) {
+        int64_t start = benchNanos();
+        fn();
+        best = std::fmin(best, (benchNanos() - start)/samplesPerRun);
+    }
+    return best;
+}
+
+}
+
+int runLfoBenchmark()
+{
+    std::printf("largest error against an exact sine, 10 minutes at %g Hz, +/-%g degrees:\n", fs, stereo);
+    std::printf("%10s %14s %14s %14s\n", "rate Hz", "table fixed", "table float", "quadrature");
+    for (float freq : { 0.1f, (float) RATE_DEFAULT, (float) RATE_MAX }) {
+        Errors errors = measureAccuracy(freq, 10);
+        std::printf("%10g %14.3g %14.3g %14.3g\n", freq, errors.table, errors.tableFloat, errors.quad);
+    }
+    std::printf("(the float-phase table's error is drift: its phase gathers float rounding every tick)\n");
+
+    const int blockSize = STAGE_BLOCK_SIZE, numBlocks = 20000;
+    static float out1[STAGE_BLOCK_SIZE], out2[STAGE_BLOCK_SIZE];
+    TablePair table(true, RATE_DEFAULT);
+    Mu45QuadLFO quad;
+    quad.setFreq(RATE_DEFAULT, fs);
+    quad.setPhaseOffset(stereo);
+    double perRun = (double) blockSize*numBlocks;
+
+    double tableTick = nanosPerSample([&] {
+        for (int b = 0; b < numBlocks; b++) {
+            for (int i = 0; i < blockSize; i++) {
+                out1[i] = table.left.tick();
+                out2[i] = table.right.tick();
+            }
+            benchKeep(out1[0] + out2[blockSize - 1]);
+        }
+    }, perRun);
+    double tableBlock = nanosPerSample([&] {
+        for (int b = 0; b < numBlocks; b++) {
+            table.left.tick(out1, blockSize);
+            table.right.tick(out2, blockSize);
+            benchKeep(out1[0] + out2[blockSize - 1]);
+        }
+    }, perRun);
+    double quadTick = nanosPerSample([&] {
+        for (int b = 0; b < numBlocks; b++) {
+            for (int i = 0; i < blockSize; i++)
+                quad.tick(out1[i], out2[i]);
+            benchKeep(out1[0] + out2[blockSize - 1]);
+        }
+    }, perRun);
+    double quadBlock = nanosPerSample([&] {
+        for (int b = 0; b < numBlocks; b++) {
+            quad.tick(out1, out2, blockSize);
+            benchKeep(out1[0] + out2[blockSize - 1]);
+        }
+    }, perRun);
+
+    // what a parameter recompute and a transport jump cost each LFO type
+    const int numUpdates = 200000;
+    double tableUpdate = nanosPerSample([&] {
+        for (int u = 0; u < numUpdates; u++)
+            table.update(RATE_DEFAULT + (u & 15)*0.01f);
+        benchKeep(table.left.tick());
+    }, numUpdates);
+    double quadUpdate = nanosPerSample([&] {
+        for (int u = 0; u < numUpdates; u++) {
+            quad.setFreq(RATE_DEFAULT + (u & 15)*0.01f, fs);
+            quad.setPhaseOffset(stereo);
+        }
+        quad.tick(out1[0], out2[0]);
+        benchKeep(out1[0]);
+    }, numUpdates);
+    double tableSeek = nanosPerSample([&] {
+        for (int u = 0; u < numUpdates; u++) {
+            table.left.seek((uint64_t) u*4099);
+            table.right.seek((uint64_t) u*4099);
+        }
+        benchKeep(table.left.tick());
+    }, numUpdates);
+    double quadSeek = nanosPerSample([&] {
+        for (int u = 0; u < numUpdates; u++)
+            quad.seek((uint64_t) u*4099);
+        quad.tick(out1[0], out2[0]);
+        benchKeep(out1[0]);
+    }, numUpdates);
+
+    std::printf("\ncost, both channels (fixed-point table):\n");
+    std::printf("%-36s %10s %10s\n", "", "table", "quadrature");
+    std::printf("%-36s %10.2f %10.2f\n", "ns per sample, one sample at a time", tableTick, quadTick);
+    std::printf("ns per sample, blocks of %-12d %10.2f %10.2f\n", blockSize, tableBlock, quadBlock);
+    std::printf("%-36s %10.2f %10.2f\n", "ns per rate and stereo change", tableUpdate, quadUpdate);
+    std::printf("%-36s %10.2f %10.2f\n", "ns per seek", tableSeek, quadSeek);
+    std::printf("%-36s %10d %10d\n", "table bytes (shared by all LFOs)", (int) (1024*sizeof(float)), 0);
+    return 0;
+}
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Runs the benchmarks named on the command line, or all of them.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include <cstdio>
+#include <cstring>
+
+static const struct {
+    const char* name;
+    const char* description;
+    int (*run)();
+} benchmarks[] = {
+    { "counters", "hardware counters per sample for each DSP kernel and processBlock (Linux perf_event)", runCounterBenchmark },
+    { "instances", "1000 plugin instances: construction, prepareToPlay and destruction time, footprint", runInstanceBenchmark },
+    { "lfo", "wavetable and quadrature LFOs: accuracy against an exact sine, cost per sample", runLfoBenchmark },
+    { "overhead", "processBlock cost split into a fixed cost per call and a cost per sample", runOverheadBenchmark },
+    { "worstcase", "processBlock tail latency with a cold cache against the real-time deadline", runWorstCaseBenchmark },
+};
+
+static const int numBenchmarks = sizeof(benchmarks)/sizeof(benchmarks[0]);
+
+int main (int argc, char* argv[])
+{
+    if (argc > 1 && (std::strcmp(argv[1], "-h") == 0 || std::strcmp(argv[1], "--help") == 0)) {
+        std::printf("usage: %s [benchmark...]\n", argv[0]);
+        for (int b = 0; b < numBenchmarks; b++)
+            std::printf("  %-12s %s\n", benchmarks[b].name, benchmarks[b].description);
+        return 0;
+    }
+
+    for (int a = 1; a < argc; a++) {
+        int b = 0;
+        while (b < numBenchmarks && std::strcmp(argv[a], benchmarks[b].name) != 0)
+            b++;
+        if (b == numBenchmarks) {
+            std::fprintf(stderr, "unknown benchmark: %s (-h lists them)\n", argv[a]);
+            return 1;
+        }
+    }
+
+    int failed = 0;
+    for (int b = 0; b < numBenchmarks; b++) {
+        bool selected = argc <= 1;
+        for (int a = 1; a < argc; a++)
+            selected = selected || std::strcmp(argv[a], benchmarks[b].name) == 0;
+        if (! selected)
+            continue;
+
+        std::printf("== %s: %s\n", benchmarks[b].name, benchmarks[b].description);
+        std::fflush(stdout);
+        failed += benchmarks[b].run();
+        std::printf("\n");
+    }
+    return failed == 0 ? 0 : 1;
+}
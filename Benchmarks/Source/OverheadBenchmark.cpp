@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    OverheadBenchmark.cpp
+    processBlock time per call against buffer size: what a call costs before
+    it touches a sample, and what each sample adds.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "../../Source/PluginProcessor.h"
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+const double fs = 48000;
+const int sizes[] = { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512 };
+const int numSizes = sizeof(sizes)/sizeof(sizes[0]);
+const int maxSize = 512;
+const long samplesPerRun = 1 << 19;
+
+enum Automation { none, rateOnly, allParams };
+
+// moves the automated parameters by a small step every call, so each call
+// sees a change, as it would under dense host automation
+void automate(ColemanJP04ChorusAudioProcessor& processor, Automation automation, long call)
+{
+    float step = (call & 1) ? 0.01f : 0.0f;
+    if (automation == none)
+        return;
+    benchSetParameter(processor, benchRate, RATE_DEFAULT + step);
+    if (automation == allParams) {
+        benchSetParameter(processor, benchDepth, DEPTH_DEFAULT + step);
+        benchSetParameter(processor, benchFocus, FOCUS_DEFAULT + 10*step);
+        benchSetParameter(processor, benchWet, WET_DEFAULT - step);
+        benchSetParameter(processor, benchDry, DRY_DEFAULT - step);
+        benchSetParameter(processor, benchStereo, STEREO_DEFAULT + 100*step);
+        benchSetParameter(processor, benchDelay, DELAY_DEFAULT + step);
+    }
+}
+
+// best of several runs, in ns per processBlock call of numSamples samples
+double nanosPerCall(Automation automation, int numSamples)
+{
+    ColemanJP04ChorusAudioProcessor processor;
+    processor.prepareToPlay(fs, maxSize);
+    juce::AudioBuffer<float> buffer(2, numSamples);
+    juce::MidiBuffer midi;
+    long numCalls = samplesPerRun/numSamples;
+
+    double best = 1e30;
+    for (int run = 0; run < 7; run++) {
+        benchFillInput(buffer);
+        int64_t start = benchNanos();
+        for (long call = 0; call < numCalls; call++) {
+            automate(processor, automation, call);
+            processor.processBlock(buffer, midi);
+        }
+        best = std::fmin(best, (double) (benchNanos() - start)/numCalls);
+        benchKeep(buffer.getReadPointer(0)[0]);
+    }
+    return best;
+}
+
+// Fits ns per call = fixed + perSample*size, weighting each size by 1/time^2
+// so the small buffers, where the fixed cost shows, count as much as the large.
+void fit(const double* nanos, double& fixed, double& perSample)
+{
+    double sw = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (int s = 0; s < numSizes; s++) {
+        double w = 1/(nanos[s]*nanos[s]), x = sizes[s], y = nanos[s];
+        sw += w; sx += w*x; sy += w*y; sxx += w*x*x; sxy += w*x*y;
+    }
+    perSample = (sw*sxy - sx*sy)/(sw*sxx - sx*sx);
+    fixed = (sy - perSample*sx)/sw;
+}
+
+}
+
+int runOverheadBenchmark()
+{
+    static const struct {
+        Automation automation;
+        const char* name;
+    } cases[] = {
+        { none, "parameters unchanged" },
+        { rateOnly, "rate changed every call" },
+        { allParams, "all parameters changed every call" },
+    };
+
+    std::printf("%g Hz stereo, %ld samples per run, best of 7 runs\n", fs, samplesPerRun);
+    for (auto& c : cases) {
+        double nanos[numSizes];
+        for (int s = 0; s < numSizes; s++)
+            nanos[s] = nanosPerCall(c.automation, sizes[s]);
+        double fixed, perSample;
+        fit(nanos, fixed, perSample);
+
+        std::printf("\n%s: %.1f ns fixed per call, %.2f ns per sample\n", c.name, fixed, perSample);
+        std::printf("%8s %12s %12s %12s\n", "samples", "ns/call", "ns/sample", "fixed share");
+        for (int s = 0; s < numSizes; s++)
+            std::printf("%8d %12.1f %12.2f %11.0f%%\n", sizes[s], nanos[s], nanos[s]/sizes[s],
+                        100*std::fmin(1.0, std::fmax(0.0, fixed/nanos[s])));
+    }
+    return 0;
+}
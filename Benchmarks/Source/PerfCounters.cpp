@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    PerfCounters.cpp
+    Hardware event counters for the calling thread (Linux perf_event).
+
+  ==============================================================================
+*/
+
+#include "PerfCounters.h"
+#include <cstring>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+PerfCounters::PerfCounters()
+{
+    leader = -1;
+    for (int c = 0; c < NUM_COUNTERS; c++)
+        fds[c] = slots[c] = -1;
+
+#if defined(__linux__)
+    static const struct { uint32_t type; uint64_t config; } events[NUM_COUNTERS] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                              | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    };
+
+    int opened = 0;
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[c].type;
+        attr.config = events[c].config;
+        attr.disabled = leader < 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        fds[c] = (int) syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+        if (fds[c] < 0)
+            continue;
+        slots[c] = opened++;
+        if (leader < 0)
+            leader = fds[c];
+    }
+    if (leader >= 0)
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#if defined(__linux__)
+    // members before the leader, which owns the group
+    for (int c = NUM_COUNTERS - 1; c >= 0; c--)
+        if (fds[c] >= 0 && fds[c] != leader)
+            close(fds[c]);
+    if (leader >= 0)
+        close(leader);
+#endif
+}
+
+void PerfCounters::read(uint64_t* values) const
+{
+    std::memset(values, 0, NUM_COUNTERS*sizeof(uint64_t));
+#if defined(__linux__)
+    if (leader < 0)
+        return;
+
+    struct { uint64_t count; uint64_t values[NUM_COUNTERS]; } group;
+    if (::read(leader, &group, sizeof(group)) < (ssize_t) sizeof(uint64_t))
+        return;
+    for (int c = 0; c < NUM_COUNTERS; c++)
+        if (slots[c] >= 0 && (uint64_t) slots[c] < group.count)
+            values[c] = group.values[slots[c]];
+#endif
+}
+
+const char* PerfCounters::name(Counter counter)
+{
+    static const char* const names[NUM_COUNTERS] = {
+        "cycles", "instructions", "L1D misses", "LLC misses", "branch misses"
+    };
+    return names[counter];
+}
@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+
+    PerfCounters.h
+    Hardware event counters for the calling thread (Linux perf_event).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <cstdint>
+
+// One perf_event group counting the calling thread in user space, opened by the
+// constructor and closed by the destructor. read() takes every counter at once
+// with a single system call. Counters the kernel or CPU doesn't offer (a VM
+// without a PMU, perf_event_paranoid too high, or not Linux) are left out and
+// read as 0; has() tells which were opened.
+class PerfCounters {
+public:
+    enum Counter {
+        CYCLES,
+        INSTRUCTIONS,
+        L1D_MISSES,     // L1 data cache read misses
+        LLC_MISSES,     // last level cache misses; perf has no generic L2 event
+        BRANCH_MISSES,
+        NUM_COUNTERS
+    };
+
+    PerfCounters();
+    ~PerfCounters();
+
+    bool has(Counter counter) const { return slots[counter] >= 0; }
+    bool any() const { return leader >= 0; }
+    void read(uint64_t* values) const;
+
+    static const char* name(Counter counter);
+
+private:
+    int leader;                 // group leader fd, -1 if nothing opened
+    int fds[NUM_COUNTERS];      // -1 for counters that couldn't be opened
+    int slots[NUM_COUNTERS];    // position in the group's read, or -1
+
+    JUCE_DECLARE_NON_COPYABLE (PerfCounters)
+};
@@ -0,0 +1,130 @@
+/*
+  ==============================================================================
+
+    WorstCaseBenchmark.cpp
+    The slowest processBlock calls rather than the average: a million calls
+    per scenario, each with a cold cache, against the real-time deadline.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "../../Source/PluginProcessor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const double fs = 48000;
+const int blockSize = 64;
+const long numCalls = 1000000;
+
+// Read between calls, a line at a time, to push the delay lines, filters and
+// processor state out of L1 and L2 (2 MB on current desktop parts). A last-level
+// cache is too large to flush a million times in a usable run.
+const size_t evictBytes = 3 << 20;
+
+enum Scenario { defaults, maxDepth, maxRate, focusSweep, allMax };
+
+void setUp(ColemanJP04ChorusAudioProcessor& processor, Scenario scenario)
+{
+    if (scenario == maxDepth || scenario == allMax) {
+        benchSetParameter(processor, benchDepth, DEPTH_MAX);
+        benchSetParameter(processor, benchDelay, DELAY_MAX); // the longest modulated delay
+    }
+    if (scenario == maxRate || scenario == allMax)
+        benchSetParameter(processor, benchRate, RATE_MAX);
+    if (scenario == allMax)
+        benchSetParameter(processor, benchStereo, STEREO_MAX);
+}
+
+// a log sweep across the focus range and back every second, so every call
+// glides the filters and recomputes their coefficients per sample
+void automate(ColemanJP04ChorusAudioProcessor& processor, Scenario scenario, long call)
+{
+    if (scenario != focusSweep && scenario != allMax)
+        return;
+    const long callsPerSweep = (long) (fs/blockSize);
+    double position = (double) (call % callsPerSweep)/callsPerSweep;
+    double fraction = position < 0.5 ? 2*position : 2 - 2*position;
+    benchSetParameter(processor, benchFocus, (float) (FOCUS_MIN*std::pow((double) FOCUS_MAX/FOCUS_MIN, fraction)));
+}
+
+unsigned evict(const std::vector<unsigned char>& junk)
+{
+    unsigned sum = 0;
+    for (size_t i = 0; i < junk.size(); i += 64)
+        sum += junk[i];
+    return sum;
+}
+
+double percentile(std::vector<float>& micros, double fraction)
+{
+    size_t rank = std::min(micros.size() - 1, (size_t) (fraction*micros.size()));
+    std::nth_element(micros.begin(), micros.begin() + rank, micros.end());
+    return micros[rank];
+}
+
+}
+
+int runWorstCaseBenchmark()
+{
+    static const struct {
+        Scenario scenario;
+        const char* name;
+    } scenarios[] = {
+        { defaults, "default parameters" },
+        { maxDepth, "max depth and delay" },
+        { maxRate, "max rate" },
+        { focusSweep, "focus sweep" },
+        { allMax, "all of the above" },
+    };
+
+    const double deadlineMicros = blockSize*1e6/fs;
+    std::printf("%ld calls of %d samples at %g Hz per scenario, %.0f us deadline, %d kB evicted before each call\n",
+                numCalls, blockSize, fs, deadlineMicros, (int) (evictBytes >> 10));
+    std::printf("%-22s %9s %9s %9s %9s %9s %9s %9s\n", "times in us", "median", "p99", "p99.9", "p99.99", "max",
+                "max/ddl", "overruns");
+
+    std::vector<unsigned char> junk(evictBytes, 1);
+    std::vector<float> input(2*blockSize);
+    for (int i = 0; i < blockSize; i++) {
+        input[i] = 0.5f*std::sin(0.05f*i);
+        input[blockSize + i] = 0.5f*std::cos(0.03f*i);
+    }
+
+    for (auto& s : scenarios) {
+        ColemanJP04ChorusAudioProcessor processor;
+        setUp(processor, s.scenario);
+        processor.prepareToPlay(fs, blockSize);
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::MidiBuffer midi;
+        std::vector<float> micros((size_t) numCalls);
+        unsigned junkSum = 0;
+        long overruns = 0;
+
+        for (long call = 0; call < numCalls; call++) {
+            for (int ch = 0; ch < 2; ch++)
+                std::copy(input.begin() + ch*blockSize, input.begin() + (ch + 1)*blockSize, buffer.getWritePointer(ch));
+            automate(processor, s.scenario, call);
+            junkSum += evict(junk);
+
+            int64_t start = benchNanos();
+            processor.processBlock(buffer, midi);
+            micros[(size_t) call] = (float) ((benchNanos() - start)*1e-3);
+            if (micros[(size_t) call] > deadlineMicros)
+                overruns++;
+        }
+        benchKeep(junkSum + buffer.getReadPointer(0)[0]);
+
+        double maxMicros = *std::max_element(micros.begin(), micros.end());
+        std::printf("%-22s %9.2f %9.2f %9.2f %9.2f %9.2f %8.2f%% %9ld\n", s.name,
+                    percentile(micros, 0.5), percentile(micros, 0.99), percentile(micros, 0.999),
+                    percentile(micros, 0.9999), maxMicros, 100*maxMicros/deadlineMicros, overruns);
+        std::fflush(stdout);
+    }
+    std::printf("(max/ddl is the slowest call as a share of the deadline; an overrun is a call past it)\n");
+    return 0;
+}
@@ -61,6 +61,59 @@
 
 #define INST_DELAY_MIN  1 // instantaneous delay minimum in ms, bottom of delay LFO
 
+#define MAX_SAMPLE_RATE 192000 // delay lines are allocated once for this rate (or the actual rate, if higher)
+
+// delay line history storage: 64 (double), 32 (float) or 16 (int16) bits per sample
+#ifndef DELAY_HISTORY_BITS
+#define DELAY_HISTORY_BITS 64
+#endif
+
+// LFO phase: 1 for a 32-bit fixed-point accumulator (exact over long runs), 0 for float
+#ifndef LFO_FIXED_POINT
+#define LFO_FIXED_POINT 1
+#endif
+
+// LFO type: 1 for one quadrature rotator giving both channels, 0 for a wavetable LFO per channel
+#ifndef LFO_QUADRATURE
+#define LFO_QUADRATURE 0
+#endif
+
+#define NUM_PARAMS      7 // depth, rate, focus, wet, dry, stereo, delay
+
+// processing statistics shown in the editor: 1 to record them, 0 to compile them out
+#ifndef PROCESS_STATS
+#define PROCESS_STATS 1
+#endif
+
+// stage trace markers in processBlock (StageTrace.h): 1 to record them, 0 to compile them out
+#ifndef STAGE_TRACE
+#define STAGE_TRACE 0
+#endif
+#define STAGE_TRACE_RING_SIZE   4096 // records kept per thread, a power of two
+#define STAGE_TRACE_THREADS     16   // threads that can record
+
+// processing
+#define STAGE_BLOCK_SIZE        256  // most samples each stage of processBlock runs over at once
+#ifndef FORCE_SCALAR_KERNELS
+#define FORCE_SCALAR_KERNELS 0 // 1 to start with the SIMD kernels off (DspKernels::setForceScalar)
+#endif
+
+// automation
+#define PARAM_RAMP_MS           10   // glide time toward a new parameter value
+#define PARAM_EVENT_QUEUE_SIZE  256  // sample-accurate parameter changes held at once
+
+// programs
+#define MAX_PROGRAMS        128  // factory plus user presets held in memory
+#define PRESET_NAME_LENGTH  32   // including the terminating null
+#define PRESET_FILE_PATTERN "*.chorus"
+#define PRESET_DIRECTORY    "Musi45/ColemanJ-P04-Chorus/Presets"
+
+// saved state
+#define STATE_MAGIC         "MuCh" // first four bytes of the binary state
+#define STATE_VERSION       1      // bump when appending data after the parameter entries
+#define STATE_HEADER_BYTES  8      // magic, uint16 version, uint16 parameter count
+#define STATE_MAX_BYTES     1024   // upper bound on the size of the binary state
+
 // GUI
 
 #define UNIT_LENGTH_X       30
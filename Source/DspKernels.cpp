@@ -0,0 +1,257 @@
+/*
+  ==============================================================================
+
+    DspKernels.cpp
+    Block kernels with SIMD variants chosen at runtime.
+
+  ==============================================================================
+*/
+
+#include "DspKernels.h"
+#include <atomic>
+
+// Every variant must round alike, so multiplies and adds are never fused
+// (AVX-512 implies FMA, which would otherwise be used wherever it fits).
+// GCC has no pragma for this: the projects build this file with -ffp-contract=off.
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(_MSC_VER)
+#pragma fp_contract (off)
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define KERNELS_X86 1
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#else
+#define KERNELS_X86 0
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define KERNEL_INLINE __forceinline
+#define RESTRICT __restrict
+#else
+#define KERNEL_INLINE inline __attribute__((always_inline))
+#define RESTRICT __restrict__
+#endif
+
+// The forced-scalar loops, kept from being vectorized where the compiler has a
+// loop pragma for it. GCC before 14 has none and may vectorize them at its
+// baseline ISA; the results are the same, as no loop here reorders arithmetic.
+#if defined(__clang__)
+#define SCALAR_LOOP _Pragma("clang loop vectorize(disable) interleave(disable)")
+#elif defined(__GNUC__) && __GNUC__ >= 14
+#define SCALAR_LOOP _Pragma("GCC novector")
+#elif defined(_MSC_VER)
+#define SCALAR_LOOP __pragma(loop(no_vector))
+#else
+#define SCALAR_LOOP
+#endif
+
+namespace {
+
+std::atomic<bool> forceScalar(FORCE_SCALAR_KERNELS != 0);
+
+DspKernels::Isa active()
+{
+    static const DspKernels::Isa best = DspKernels::detectedIsa();
+    return forceScalar.load(std::memory_order_relaxed) ? DspKernels::SCALAR : best;
+}
+
+//==============================================================================
+// The loop bodies, inlined into one function per instruction set. The
+// fraction is converted from a signed int, which every SIMD set can do.
+
+KERNEL_INLINE void wavetableLoop(float* RESTRICT output, int numSamples, const float* RESTRICT table,
+                                 int fracBits, uint32_t phase, uint32_t increment)
+{
+    const uint32_t indexMask = 0xFFFFFFFFu >> fracBits;
+    const uint32_t fracMask = (1u << fracBits) - 1;
+    const float fracScale = 1.0f/(1u << fracBits);
+    for (int i = 0; i < numSamples; i++) {
+        uint32_t p = phase + (uint32_t) i*increment;
+        int idx1 = (int) (p >> fracBits);
+        int idx2 = (int) (((p >> fracBits) + 1) & indexMask);
+        float frac = (int) (p & fracMask) * fracScale;
+        output[i] = table[idx1] + frac*(table[idx2] - table[idx1]);
+    }
+}
+
+template <typename FloatType>
+KERNEL_INLINE void mixCrossedLoop(FloatType* RESTRICT left, FloatType* RESTRICT right,
+                                  const FloatType* RESTRICT leftWet, const FloatType* RESTRICT rightWet,
+                                  int numSamples, float dryGain, float wetGain)
+{
+    for (int i = 0; i < numSamples; i++) {
+        FloatType leftSample = left[i], rightSample = right[i];
+        left[i] = leftSample*dryGain + rightWet[i]*wetGain;
+        right[i] = rightSample*dryGain + leftWet[i]*wetGain;
+    }
+}
+
+//==============================================================================
+void wavetableScalar(float* output, int numSamples, const float* table,
+                     int fracBits, uint32_t phase, uint32_t increment)
+{
+    const uint32_t indexMask = 0xFFFFFFFFu >> fracBits;
+    const uint32_t fracMask = (1u << fracBits) - 1;
+    const float fracScale = 1.0f/(1u << fracBits);
+    SCALAR_LOOP
+    for (int i = 0; i < numSamples; i++, phase += increment) {
+        int idx1 = (int) (phase >> fracBits);
+        int idx2 = (int) (((phase >> fracBits) + 1) & indexMask);
+        float frac = (int) (phase & fracMask) * fracScale;
+        output[i] = table[idx1] + frac*(table[idx2] - table[idx1]);
+    }
+}
+
+template <typename FloatType>
+void mixCrossedScalar(FloatType* left, FloatType* right, const FloatType* leftWet, const FloatType* rightWet,
+                      int numSamples, float dryGain, float wetGain)
+{
+    SCALAR_LOOP
+    for (int i = 0; i < numSamples; i++) {
+        FloatType leftSample = left[i], rightSample = right[i];
+        left[i] = leftSample*dryGain + rightWet[i]*wetGain;
+        right[i] = rightSample*dryGain + leftWet[i]*wetGain;
+    }
+}
+
+#if KERNELS_X86
+// The compilers load the table one element at a time here, so the AVX2
+// variant gathers eight at once instead. AVX-512 uses it too: wider gathers
+// were no faster.
+KERNEL_TARGET("avx2") void wavetableAvx2(float* output, int numSamples, const float* table,
+                                         int fracBits, uint32_t phase, uint32_t increment)
+{
+    const __m128i shift = _mm_cvtsi32_si128(fracBits);
+    const __m256i indexMask = _mm256_set1_epi32((int) (0xFFFFFFFFu >> fracBits));
+    const __m256i fracMask = _mm256_set1_epi32((int) ((1u << fracBits) - 1));
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256 fracScale = _mm256_set1_ps(1.0f/(1u << fracBits));
+    const __m256i step = _mm256_set1_epi32((int) (8*increment));
+    __m256i p = _mm256_add_epi32(_mm256_set1_epi32((int) phase),
+                                 _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32((int) increment)));
+    int i = 0;
+    for (; i + 8 <= numSamples; i += 8, p = _mm256_add_epi32(p, step)) {
+        __m256i idx1 = _mm256_srl_epi32(p, shift);
+        __m256i idx2 = _mm256_and_si256(_mm256_add_epi32(idx1, one), indexMask);
+        __m256 frac = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(p, fracMask)), fracScale);
+        __m256 a = _mm256_i32gather_ps(table, idx1, 4);
+        __m256 b = _mm256_i32gather_ps(table, idx2, 4);
+        _mm256_storeu_ps(output + i, _mm256_add_ps(a, _mm256_mul_ps(frac, _mm256_sub_ps(b, a))));
+    }
+    wavetableLoop(output + i, numSamples - i, table, fracBits, phase + (uint32_t) i*increment, increment);
+}
+
+template <typename FloatType>
+KERNEL_TARGET("avx2") void mixCrossedAvx2(FloatType* left, FloatType* right, const FloatType* leftWet, const FloatType* rightWet,
+                                          int numSamples, float dryGain, float wetGain)
+{
+    mixCrossedLoop(left, right, leftWet, rightWet, numSamples, dryGain, wetGain);
+}
+
+template <typename FloatType>
+KERNEL_TARGET("avx512f") void mixCrossedAvx512(FloatType* left, FloatType* right, const FloatType* leftWet, const FloatType* rightWet,
+                                               int numSamples, float dryGain, float wetGain)
+{
+    mixCrossedLoop(left, right, leftWet, rightWet, numSamples, dryGain, wetGain);
+}
+#endif
+
+template <typename FloatType>
+void mixCrossedDispatch(FloatType* left, FloatType* right, const FloatType* leftWet, const FloatType* rightWet,
+                        int numSamples, float dryGain, float wetGain)
+{
+    switch (active()) {
+        case DspKernels::SCALAR:
+            mixCrossedScalar(left, right, leftWet, rightWet, numSamples, dryGain, wetGain);
+            return;
+#if KERNELS_X86
+        case DspKernels::AVX512:
+            mixCrossedAvx512(left, right, leftWet, rightWet, numSamples, dryGain, wetGain);
+            return;
+        case DspKernels::AVX2:
+            mixCrossedAvx2(left, right, leftWet, rightWet, numSamples, dryGain, wetGain);
+            return;
+#endif
+        default: // SSE2 or NEON, the baseline the file is compiled for
+            mixCrossedLoop(left, right, leftWet, rightWet, numSamples, dryGain, wetGain);
+            return;
+    }
+}
+
+}
+
+//==============================================================================
+DspKernels::Isa DspKernels::detectedIsa()
+{
+#if KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SSE2;
+    return SCALAR;
+#elif defined(_M_X64)
+    return SSE2;
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    return NEON;
+#else
+    return SCALAR;
+#endif
+}
+
+DspKernels::Isa DspKernels::activeIsa()
+{
+    return active();
+}
+
+const char* DspKernels::isaName(Isa isa)
+{
+    switch (isa) {
+        case SSE2:   return "SSE2";
+        case AVX2:   return "AVX2";
+        case AVX512: return "AVX-512";
+        case NEON:   return "NEON";
+        default:     return "scalar";
+    }
+}
+
+void DspKernels::setForceScalar(bool force)
+{
+    forceScalar.store(force, std::memory_order_relaxed);
+}
+
+void DspKernels::wavetable(float* output, int numSamples, const float* table, int fracBits,
+                           uint32_t phase, uint32_t increment)
+{
+    switch (active()) {
+        case SCALAR:
+            wavetableScalar(output, numSamples, table, fracBits, phase, increment);
+            return;
+#if KERNELS_X86
+        case AVX512:
+        case AVX2:
+            wavetableAvx2(output, numSamples, table, fracBits, phase, increment);
+            return;
+#endif
+        default: // SSE2 or NEON, the baseline the file is compiled for
+            wavetableLoop(output, numSamples, table, fracBits, phase, increment);
+            return;
+    }
+}
+
+void DspKernels::mixCrossed(float* left, float* right, const float* leftWet, const float* rightWet,
+                            int numSamples, float dryGain, float wetGain)
+{
+    mixCrossedDispatch(left, right, leftWet, rightWet, numSamples, dryGain, wetGain);
+}
+
+void DspKernels::mixCrossed(double* left, double* right, const double* leftWet, const double* rightWet,
+                            int numSamples, float dryGain, float wetGain)
+{
+    mixCrossedDispatch(left, right, leftWet, rightWet, numSamples, dryGain, wetGain);
+}
@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    DspKernels.h
+    Block kernels with SIMD variants chosen at runtime.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include "Defines.h"
+
+// Each kernel is built once per instruction set, from the same loop or with
+// intrinsics where the compiler falls short, and the best variant the CPU
+// supports is picked when first used, so a single binary runs well on every
+// x86-64 machine: SSE2, AVX2 or AVX-512. ARM64 has no variants; NEON there
+// only names the baseline loop, which the compiler vectorizes with the NEON
+// every ARM64 CPU has. No variant fuses multiplies and adds, so all of them
+// give bit-identical results, and setForceScalar(true), which runs plain
+// sample-at-a-time loops instead, can validate them.
+//
+// The delay lines and the focus filter feed each output back into the next
+// sample, so they aren't kernels here. The focus filter runs its two channels
+// side by side instead (SVF::tickChannels).
+class DspKernels {
+public:
+    enum Isa { SCALAR, SSE2, AVX2, AVX512, NEON }; // NEON: the ARM64 baseline loop
+
+    static Isa detectedIsa();                   // best variant this CPU can run
+    static Isa activeIsa();                     // variant the kernels currently use
+    static const char* isaName(Isa isa);
+    static void setForceScalar(bool force);     // any thread; applies from the next kernel call
+
+    // Linear interpolation of a power-of-two wavetable indexed by a 32-bit
+    // fixed-point phase: the top bits index the table, the low fracBits are the
+    // fraction. The phase advances by increment each sample and wraps by overflow.
+    static void wavetable(float* output, int numSamples, const float* table, int fracBits,
+                          uint32_t phase, uint32_t increment);
+
+    // Dry and wet signals mixed in place, each wet channel crossed to the other side:
+    // left = left*dryGain + rightWet*wetGain, right = right*dryGain + leftWet*wetGain
+    static void mixCrossed(float* left, float* right, const float* leftWet, const float* rightWet,
+                           int numSamples, float dryGain, float wetGain);
+    static void mixCrossed(double* left, double* right, const double* leftWet, const double* rightWet,
+                           int numSamples, float dryGain, float wetGain);
+};
@@ -6,35 +6,69 @@
 
 #include "Mu45LFO.h"
 #include <cmath>
+#include "../DspKernels.h"
+
+// the wavetable is the same for every LFO, so it is built once, on first use, and shared
+const float* Mu45LFO::sineTable()
+{
+    struct SineTable {
+        float values[N];
+        SineTable() {
+            float pi = 3.1415926535897932384626433832795;
+            
+            // initialize a table with a sine waveform
+            for (int i = 0; i < N; i++) {
+                values[i] = sin(2*pi*i/N);
+            }
+        }
+    };
+    static const SineTable sine;    // thread-safe one-time initialization
+    return sine.values;
+}
 
 // constructor
 Mu45LFO::Mu45LFO()
 {
-    float pi = 3.1415926535897932384626433832795;
-    
-    // initialize a table with a sine waveform
-    for (int i = 0; i < N; i++) {
-        table[i] = sin(2*pi*i/N);
-    }
+    table = sineTable();
     
     // init other stuff
+    fixedPoint = false;
     setFreq(1.0, 44100);
     resetPhase();
     
     // colemanjenkins
     phaseOffset = 0;
+    phaseOffsetFixed = 0;
+}
+
+// convert a fraction of a cycle to fixed-point phase, wrapping to one cycle
+static uint32_t cyclesToFixed(double cycles)
+{
+    cycles -= floor(cycles);
+    return (uint32_t)(long long)(cycles*4294967296.0 + 0.5);
 }
 
 // set the frequency of the LFO (freq) and how often it will be called (fs). Both values are in Hz.
 void Mu45LFO::setFreq(float freq, float fs)
 {
     phase_inc = N * freq / fs;
+    phaseIncFixed = cyclesToFixed((double)freq / fs);
 }
 
 // reset the phase, so that the next output is at the beginning of the wavetable
 void Mu45LFO::resetPhase()
 {
     phase = 0.0;
+    phaseAcc = 0;
+}
+
+// set the phase the LFO would have after sampleIndex ticks from a reset at the current frequency,
+// without running them. In fixed-point mode this is exact: the product wraps just as the
+// accumulator does.
+void Mu45LFO::seek(uint64_t sampleIndex)
+{
+    phaseAcc = (uint32_t)(sampleIndex * phaseIncFixed);
+    phase = fmod(sampleIndex * (double)phase_inc, (double)N);
 }
 
 // colemanjenkins
@@ -48,11 +82,32 @@ void Mu45LFO::setPhaseOffset(float degrees) {
     }
     
     phaseOffset = (degrees/360.0)*N;
+    phaseOffsetFixed = cyclesToFixed(degrees/360.0);
+}
+
+// switch between float and fixed-point phase, keeping the current phase
+void Mu45LFO::setFixedPoint(bool on)
+{
+    if (on == fixedPoint) return;
+    
+    if (on) phaseAcc = cyclesToFixed(phase/N);
+    else phase = phaseAcc * (N/4294967296.0);
+    fixedPoint = on;
 }
 
 // update the phase of the LFO and produce an output sample
 float Mu45LFO::tick()
 {
+    if (fixedPoint) {
+        uint32_t p = phaseAcc + phaseOffsetFixed;   // overflow wraps the offset
+        int idx1 = p >> FRAC_BITS;                  // top bits index the table
+        int idx2 = (idx1 + 1) & (N - 1);
+        float frac = (p & ((1u << FRAC_BITS) - 1)) * (1.0f/(1u << FRAC_BITS));
+        
+        phaseAcc += phaseIncFixed;                  // overflow wraps the phase
+        return table[idx1] + frac*(table[idx2] - table[idx1]);
+    }
+    
     // calc output
     float outSamp, frac;
     int idx1, idx2;         // the indeces to the two table entries we will interpolate between
@@ -80,15 +135,15 @@ float Mu45LFO::tick()
     return outSamp;
 }
 
-
-
-
-
-
-
-
-
-
-
-
-
+// generate numSamples outputs into output
+void Mu45LFO::tick(float* output, int numSamples)
+{
+    if (!fixedPoint) {
+        for (int i = 0; i < numSamples; i++) output[i] = tick();
+        return;
+    }
+    
+    // the same as tick(), in the SIMD variant this CPU supports
+    DspKernels::wavetable(output, numSamples, table, FRAC_BITS, phaseAcc + phaseOffsetFixed, phaseIncFixed);
+    phaseAcc += (uint32_t)numSamples * phaseIncFixed;
+}
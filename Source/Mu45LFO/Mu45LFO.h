@@ -6,10 +6,17 @@
 // Mu45LFO is a low-frequency oscillator with basic functionality.
 // The LFO outputs a sinusoidal waveform, which is created by interpolating
 // a 1024-sample wavetable.
+//
+// By default the phase is a float index into the table. In fixed-point mode
+// it is a 32-bit integer accumulator covering one cycle: the top 10 bits
+// index the table, the low 22 bits are the interpolation fraction, and
+// wraparound is the accumulator's natural overflow. The phase then never
+// drifts, however long the LFO runs, and tick() needs no floor() or compare.
 
 #ifndef __mu45_Mu45LFO__
 #define __mu45_Mu45LFO__
 #include <stdio.h>
+#include <stdint.h>
 #endif /* defined(__mu45_Mu45LFO__) */
 
 
@@ -19,16 +26,29 @@ public:
     void setFreq(float freq, float fs);     // Set the frequency of the oscillator.
     float tick();                           // Generate a sample of output and update the state
     void resetPhase();                      // Set the oscillator phase to 0
+    void seek(uint64_t sampleIndex);        // Set the phase to sampleIndex ticks after a reset
     
     // colemanjenkins
     void setPhaseOffset(float degrees);     // set phase offset in degrees
     
+    void setFixedPoint(bool on);            // use the 32-bit integer phase accumulator
+    bool isFixedPoint() const { return fixedPoint; }
+    void tick(float* output, int numSamples);   // generate a block of output
+    
 private:
     static const int N = 1024;      // size of the wavetable
-    float table[N];                 // the wavetable
+    static const float* sineTable();
+    const float* table;             // the wavetable, shared by all LFOs
     float phase_inc;                // amount to increment phase each tick
     float phase;                    // current index into the wavetable
     
     // colemanjenkins
     float phaseOffset;              // phase offset in samples
+    
+    // fixed-point phase, in units of 2^-32 cycles
+    static const int FRAC_BITS = 22;    // phase bits below the table index, 32 - log2(N)
+    bool fixedPoint;
+    uint32_t phaseAcc;
+    uint32_t phaseIncFixed;
+    uint32_t phaseOffsetFixed;
 };
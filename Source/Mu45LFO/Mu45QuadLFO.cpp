@@ -0,0 +1,102 @@
+//
+//  Mu45QuadLFO.cpp
+//
+
+#include "Mu45QuadLFO.h"
+#include <cmath>
+
+// constructor
+Mu45QuadLFO::Mu45QuadLFO()
+{
+    setFreq(1.0, 44100);
+    resetPhase();
+    setPhaseOffset(0);
+}
+
+// set the frequency of the LFO (freq) and how often it will be called (fs). Both values are in Hz.
+void Mu45QuadLFO::setFreq(float freq, float fs)
+{
+    cyclesPerTick = (double)freq/fs;
+    double w = 2*3.1415926535897932384626433832795*cyclesPerTick;
+    rotRe = cos(w);
+    rotIm = sin(w);
+    rot4Re = cos(4*w);
+    rot4Im = sin(4*w);
+}
+
+// reset the phase, so that the next output is sin(offset)
+void Mu45QuadLFO::resetPhase()
+{
+    re = 1.0;
+    im = 0.0;
+    count = 0;
+}
+
+// set the phase the LFO would have after sampleIndex ticks from a reset at the current frequency
+void Mu45QuadLFO::seek(uint64_t sampleIndex)
+{
+    double cycles = sampleIndex*cyclesPerTick;
+    double w = 2*3.1415926535897932384626433832795*(cycles - floor(cycles));
+    re = cos(w);
+    im = sin(w);
+    count = 0;
+}
+
+void Mu45QuadLFO::setPhaseOffset(float degrees)
+{
+    double d = 2*3.1415926535897932384626433832795*degrees/360.0;
+    offRe = cos(d);
+    offIm = sin(d);
+}
+
+// generate numSamples of both outputs
+void Mu45QuadLFO::tick(float* out1, float* out2, int numSamples)
+{
+    // Four rotators, one tick apart, each advanced by four ticks at a time.
+    // They are independent, so the rotation is no longer one long chain of
+    // dependent multiplies and the lanes can run in parallel (or as SIMD).
+    double laneRe[4], laneIm[4];
+    laneRe[0] = re;
+    laneIm[0] = im;
+    for (int k = 1; k < 4; k++) {
+        laneRe[k] = laneRe[k-1]*rotRe - laneIm[k-1]*rotIm;
+        laneIm[k] = laneRe[k-1]*rotIm + laneIm[k-1]*rotRe;
+    }
+    
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        for (int k = 0; k < 4; k++) {
+            float s = laneIm[k]*offRe, c = laneRe[k]*offIm;
+            out1[i+k] = s + c;
+            out2[i+k] = s - c;
+            double next = laneRe[k]*rot4Re - laneIm[k]*rot4Im;
+            laneIm[k] = laneRe[k]*rot4Im + laneIm[k]*rot4Re;
+            laneRe[k] = next;
+        }
+        count += 4;
+        if (count >= RENORM_INTERVAL) {
+            for (int k = 0; k < 4; k++) {
+                double g = 1.5 - 0.5*(laneRe[k]*laneRe[k] + laneIm[k]*laneIm[k]);
+                laneRe[k] *= g;
+                laneIm[k] *= g;
+            }
+            count = 0;
+        }
+    }
+    
+    // lane 0 is now at the next tick's phase
+    re = laneRe[0];
+    im = laneIm[0];
+    for (; i < numSamples; i++)
+        tick(out1[i], out2[i]);
+}
+
+// pull the magnitude back to 1. It is always within a few ulps of 1, so one
+// Newton step for 1/sqrt(m) at m = 1 is exact to double precision.
+void Mu45QuadLFO::renormalize()
+{
+    double g = 1.5 - 0.5*(re*re + im*im);
+    re *= g;
+    im *= g;
+    count = 0;
+}
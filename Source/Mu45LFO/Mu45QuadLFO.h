@@ -0,0 +1,63 @@
+//
+//  Mu45QuadLFO.h
+//
+
+// Mu45QuadLFO is a sinusoidal low-frequency oscillator with two outputs,
+// for a stereo pair of modulators. Instead of a wavetable it rotates a
+// unit complex number by a fixed angle each tick, which gives the sine and
+// cosine of the phase together. The two outputs lead and lag that phase by
+// the phase offset, so each is a constant rotation of the same oscillator
+// rather than a second oscillator. Rounding slowly changes the magnitude
+// of the rotating value, so it is renormalized every RENORM_INTERVAL ticks.
+//
+// Compared with a pair of Mu45LFOs it uses no table memory and its output
+// is an exact sine: over ten minutes at 48 kHz its largest error is 9e-8
+// (float rounding), against 5e-6 for the interpolated table. It costs more,
+// though: about the same one sample at a time, but in blocks nearly twice
+// the table's SIMD block tick() (its four rotators still each wait on the
+// last), and a rate or stereo change needs four trig calls. Seeking is
+// cheaper. The processor uses it only if LFO_QUADRATURE is set; the "lfo"
+// benchmark in Benchmarks/ measures both.
+
+#ifndef __mu45_Mu45QuadLFO__
+#define __mu45_Mu45QuadLFO__
+#include <stdint.h>
+
+class Mu45QuadLFO {
+public:
+    Mu45QuadLFO();                          // Constructor
+    void setFreq(float freq, float fs);     // Set the frequency of the oscillator.
+    void tick(float& out1, float& out2);    // Generate a sample of both outputs and update the state
+    void tick(float* out1, float* out2, int numSamples);    // generate a block of both outputs
+    void resetPhase();                      // Set the oscillator phase to 0
+    void seek(uint64_t sampleIndex);        // Set the phase to sampleIndex ticks after a reset
+    void setPhaseOffset(float degrees);     // out1 leads and out2 lags the phase by degrees
+    
+private:
+    static const int RENORM_INTERVAL = 64;  // ticks between magnitude corrections
+    
+    void renormalize();
+    
+    double re, im;                  // cos and sin of the current phase
+    double cyclesPerTick;           // frequency in cycles per sample
+    double rotRe, rotIm;            // rotation applied each tick
+    double rot4Re, rot4Im;          // four ticks of rotation, for block processing
+    float offRe, offIm;             // cos and sin of the phase offset
+    int count;                      // ticks since the last renormalization
+};
+
+// rotate by the offset in each direction: sin(phase + offset) and sin(phase - offset)
+inline void Mu45QuadLFO::tick(float& out1, float& out2)
+{
+    float s = im*offRe, c = re*offIm;
+    out1 = s + c;
+    out2 = s - c;
+    
+    // advance the phase
+    double next = re*rotRe - im*rotIm;
+    im = re*rotIm + im*rotRe;
+    re = next;
+    if (++count == RENORM_INTERVAL) renormalize();
+}
+
+#endif /* defined(__mu45_Mu45QuadLFO__) */
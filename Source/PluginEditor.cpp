@@ -81,6 +81,18 @@ void ColemanJP04ChorusAudioProcessorEditor::timerCallback() {
         juce::AudioParameterFloat* param = (juce::AudioParameterFloat*)params.getUnchecked(slider_param.param);
         slider_param.slider->setValue(param->get(), juce::dontSendNotification);
     }
+    
+#if PROCESS_STATS
+    if (--statsCountdown <= 0) {
+        statsCountdown = 25; // every 500 ms
+        ProcessStatsSnapshot stats = audioProcessor.getProcessStats();
+        statsText = juce::String::formatted("CPU %.1f%% (peak %.0f%%)   block p99 %.1f / p99.9 %.1f / max %.1f us   overruns %llu   recalcs %llu   clamped %llu",
+                                            stats.load*100, stats.peakLoad*100, stats.p99Micros, stats.p999Micros, stats.maxMicros,
+                                            (unsigned long long) stats.overruns, (unsigned long long) stats.paramRecalcs,
+                                            (unsigned long long) stats.clampedDelays);
+        repaint();
+    }
+#endif
 }
 
 ColemanJP04ChorusAudioProcessorEditor::~ColemanJP04ChorusAudioProcessorEditor()
@@ -109,6 +121,12 @@ void ColemanJP04ChorusAudioProcessorEditor::paint (juce::Graphics& g)
     
     g.drawText("Dry", 17*UNIT_LENGTH_X, 2*UNIT_LENGTH_Y, SLIDER_WIDTH, 1*UNIT_LENGTH_Y, juce::Justification::centred);
     g.drawText("Wet", 21*UNIT_LENGTH_X, 2*UNIT_LENGTH_Y, SLIDER_WIDTH, 1*UNIT_LENGTH_Y, juce::Justification::centred);
+    
+#if PROCESS_STATS
+    g.setColour (juce::Colours::lightblue);
+    g.setFont (juce::Font(12.0f, juce::Font::plain));
+    g.drawText(statsText, 1*UNIT_LENGTH_X, 11.2*UNIT_LENGTH_Y, 22*UNIT_LENGTH_X, 0.7*UNIT_LENGTH_Y, juce::Justification::left);
+#endif
 }
 
 void ColemanJP04ChorusAudioProcessorEditor::resized()
@@ -71,6 +71,9 @@ private:
         {&drySlider, dry}
     };
     
+    juce::String statsText; // processing statistics line, refreshed a few times a second
+    int statsCountdown = 0;
+    
     void createKnob(juce::Slider& slider, float x, float y, std::string suffix,
                     float interval, float skew, parameterMap paramNum);
     void createSlider(juce::Slider& slider, float x, float y,
@@ -9,6 +9,14 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+// factory programs, values in getParameters() order:
+// depth %, rate Hz, focus Hz, wet %, dry %, stereo, delay ms
+static const struct { const char* name; float values[NUM_PARAMS]; } factoryPrograms[] = {
+    { "Default",        { DEPTH_DEFAULT, RATE_DEFAULT, FOCUS_DEFAULT, WET_DEFAULT, DRY_DEFAULT, STEREO_DEFAULT, DELAY_DEFAULT } },
+    { "Light Chorus",   { 15, 0.8f, 150, 50, 100, 30, 12 } },
+    { "Extreme Chorus", { 90, 6, 20, 100, 70, 90, 20 } }
+};
+
 //==============================================================================
 ColemanJP04ChorusAudioProcessor::ColemanJP04ChorusAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -61,6 +69,31 @@ ColemanJP04ChorusAudioProcessor::ColemanJP04ChorusAudioProcessor()
                                                             DELAY_MAX,
                                                             DELAY_DEFAULT));
     
+    nextTimelineSample = -1;
+    samplePosition = 0;
+    rampLength = 1;
+    rampRemaining = 0;
+    std::memset(lastParamValues, 0xFF, sizeof(lastParamValues)); // NaNs, so the first block recomputes
+    stkWarnings = 0;
+    stkContext.setErrorCallback(&handleStkError, this);
+    focusHPF.setContext(&stkContext);
+    leftDelayLine.setContext(&stkContext);
+    rightDelayLine.setContext(&stkContext);
+    
+    stk::Stk::StkFormat historyFormat = stk::Stk::STK_FLOAT64;
+    if (DELAY_HISTORY_BITS == 32)
+        historyFormat = stk::Stk::STK_FLOAT32;
+    else if (DELAY_HISTORY_BITS == 16)
+        historyFormat = stk::Stk::STK_SINT16;
+    leftDelayLine.setStorageFormat(historyFormat);
+    rightDelayLine.setStorageFormat(historyFormat);
+    
+#if ! LFO_QUADRATURE
+    leftLFO.setFixedPoint(LFO_FIXED_POINT != 0);
+    rightLFO.setFixedPoint(LFO_FIXED_POINT != 0);
+#endif
+    
+    currentProgram = 0; // the program bank is only read when first asked for
 }
 
 ColemanJP04ChorusAudioProcessor::~ColemanJP04ChorusAudioProcessor()
@@ -107,26 +140,140 @@ double ColemanJP04ChorusAudioProcessor::getTailLengthSeconds() const
 
 int ColemanJP04ChorusAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return getProgramBank().numPrograms;
 }
 
 int ColemanJP04ChorusAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
+// Safe to call from the audio thread: only copies values out of the in-memory
+// bank, which prepareToPlay has read by then. processBlock glides to the new
+// values over PARAM_RAMP_MS. Only a change made on the message thread is
+// reported to the host; one from the audio thread is the host's own doing.
 void ColemanJP04ChorusAudioProcessor::setCurrentProgram (int index)
 {
+    ProgramBank& bank = getProgramBank();
+    if (index < 0 || index >= bank.numPrograms)
+        return;
+    
+    const Program* program = bank.entries[index];
+    currentProgram = index;
+    bool notifyHost = juce::MessageManager::existsAndIsCurrentThread();
+    auto& params = getParameters();
+    for (int i = 0; i < NUM_PARAMS && i < params.size(); i++) {
+        if (notifyHost)
+            *((juce::AudioParameterFloat*) params.getUnchecked(i)) = program->values[i];
+        else
+            setParameterWithoutNotifying(i, program->values[i]);
+    }
 }
 
 const juce::String ColemanJP04ChorusAudioProcessor::getProgramName (int index)
 {
-    return {};
+    ProgramBank& bank = getProgramBank();
+    if (index < 0 || index >= bank.numPrograms)
+        return {};
+    return juce::String::fromUTF8(bank.entries[index].load()->name);
 }
 
+// Renames the program for every instance, until the process exits.
 void ColemanJP04ChorusAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    ProgramBank& bank = getProgramBank();
+    const juce::ScopedLock lock (bank.writeLock);
+    if (index < 0 || index >= bank.numPrograms)
+        return;
+    
+    Program program = *bank.entries[index].load();
+    newName.copyToUTF8(program.name, PRESET_NAME_LENGTH);
+    bank.entries[index] = bank.add(program);
+}
+
+juce::File ColemanJP04ChorusAudioProcessor::getUserPresetDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile(PRESET_DIRECTORY);
+}
+
+// The bank is read by whichever instance first asks for it, once per process,
+// and never from the constructor, so creating an instance does no file I/O.
+ColemanJP04ChorusAudioProcessor::ProgramBank& ColemanJP04ChorusAudioProcessor::getProgramBank() const
+{
+    static ProgramBank bank (*this);
+    return bank;
+}
+
+// Reads the factory programs and then the user preset files; reader parses them,
+// as every instance has the same parameters.
+ColemanJP04ChorusAudioProcessor::ProgramBank::ProgramBank (const ColemanJP04ChorusAudioProcessor& reader)
+{
+    Program program;
+    int count = 0;
+    for (auto& factory : factoryPrograms) {
+        juce::String(factory.name).copyToUTF8(program.name, PRESET_NAME_LENGTH);
+        std::memcpy(program.values, factory.values, sizeof(program.values));
+        entries[count++] = add(program);
+    }
+    
+    auto files = getUserPresetDirectory().findChildFiles(juce::File::findFiles, false, PRESET_FILE_PATTERN);
+    std::sort(files.begin(), files.end());
+    for (auto& file : files) {
+        if (count >= MAX_PROGRAMS)
+            break;
+        
+        juce::MemoryBlock data;
+        if (! file.loadFileAsData(data))
+            continue;
+        
+        // start from the defaults so presets saved by older versions fill in new parameters
+        std::memcpy(program.values, factoryPrograms[0].values, sizeof(program.values));
+        if (! reader.readStateValues(data.getData(), (int) data.getSize(), program.values))
+            continue;
+        file.getFileNameWithoutExtension().copyToUTF8(program.name, PRESET_NAME_LENGTH);
+        entries[count++] = add(program);
+    }
+    numPrograms = count;
+}
+
+const ColemanJP04ChorusAudioProcessor::Program* ColemanJP04ChorusAudioProcessor::ProgramBank::add (const Program& program)
+{
+    return storage.add(new Program(program));
+}
+
+// Saving under the name of an existing user preset replaces it, on disk and in the
+// bank, for every instance. The bank keeps the file name, as a later session would load it.
+bool ColemanJP04ChorusAudioProcessor::saveUserPreset (const juce::String& name)
+{
+    juce::String fileName = juce::File::createLegalFileName(name);
+    if (fileName.isEmpty())
+        return false;
+    
+    Program program;
+    fileName.copyToUTF8(program.name, PRESET_NAME_LENGTH);
+    getParameterValues(program.values);
+    
+    ProgramBank& bank = getProgramBank();
+    const juce::ScopedLock lock (bank.writeLock);
+    int numFactory = sizeof(factoryPrograms)/sizeof(factoryPrograms[0]);
+    int index = numFactory;
+    while (index < bank.numPrograms && std::strcmp(bank.entries[index].load()->name, program.name) != 0)
+        index++;
+    if (index >= MAX_PROGRAMS)
+        return false;
+    
+    char state[STATE_MAX_BYTES];
+    size_t size = writeStateValues(state, program.values);
+    auto directory = getUserPresetDirectory();
+    directory.createDirectory();
+    auto file = directory.getChildFile(fileName).withFileExtension(juce::String(PRESET_FILE_PATTERN).substring(1));
+    if (! file.replaceWithData(state, size))
+        return false;
+    
+    bank.entries[index] = bank.add(program);
+    if (index == bank.numPrograms)
+        bank.numPrograms = index + 1; // publish after the entry
+    return true;
 }
 
 //==============================================================================
@@ -135,16 +282,63 @@ void ColemanJP04ChorusAudioProcessor::prepareToPlay (double sampleRate, int samp
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
     fs = sampleRate;
+    stkContext.setSampleRate(fs); // the focus filters follow the context rate
     
-    unsigned long maxDelay = calcDelaySampsFromMs(MAX_TOTAL_DELAY);
+    // Size the delay lines once, for the highest supported rate, so switching the
+    // session rate later reallocates nothing. Only a rate above MAX_SAMPLE_RATE grows them.
+    double allocRate = juce::jmax(sampleRate, (double) MAX_SAMPLE_RATE);
+    unsigned long maxDelay = (unsigned long) std::ceil(MAX_TOTAL_DELAY*(allocRate/1000.0));
     leftDelayLine.setMaximumDelay(maxDelay);
     rightDelayLine.setMaximumDelay(maxDelay);
+    
+    focusHPF.setMode(stk::SVF::HIGHPASS);
+    focusHPF.setQ(1);
+    
+    rampLength = juce::jmax(1, (int) std::lround(PARAM_RAMP_MS*fs/1000.0));
+    getProgramBank(); // read now if no instance has yet, so a program change on the audio thread never reads files
+    resetState();
+    processStats.reset(fs);
+}
+
+// Puts all DSP state back to where a freshly prepared instance starts, so nothing
+// from before a rate change or transport restart leaks into the next output.
+void ColemanJP04ChorusAudioProcessor::resetState()
+{
+    leftDelayLine.clear();
+    rightDelayLine.clear();
+    focusHPF.clear();
+#if LFO_QUADRATURE
+    stereoLFO.resetPhase();
+#else
+    leftLFO.resetPhase();
+    rightLFO.resetPhase();
+#endif
+    nextTimelineSample = -1;
+    samplePosition = 0;
+    calcAlgorithmParams(false); // start at the parameter values, no glide
 }
 
 void ColemanJP04ChorusAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    
+    // The delay lines are kept: hosts release and prepare again on every rate
+    // change, and keeping them is what makes that switch instant.
+    
+#if STAGE_TRACE
+    // the stage timings so far, for chrome://tracing or ui.perfetto.dev, and their mean costs
+    juce::File traceDirectory = juce::File::getSpecialLocation(juce::File::tempDirectory);
+    traceDirectory.getChildFile(juce::String(JucePlugin_Name) + "-trace.json").replaceWithText(StageTrace::toChromeJson());
+    traceDirectory.getChildFile(juce::String(JucePlugin_Name) + "-trace.txt").replaceWithText(StageTrace::summary());
+#endif
+}
+
+// STK reports errors from the audio thread, so count them rather than printing
+void ColemanJP04ChorusAudioProcessor::handleStkError(const std::string& message, stk::StkError::Type type, void* processor)
+{
+    juce::ignoreUnused(message, type);
+    static_cast<ColemanJP04ChorusAudioProcessor*>(processor)->stkWarnings++;
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -174,28 +368,165 @@ bool ColemanJP04ChorusAudioProcessor::isBusesLayoutSupported (const BusesLayout&
 }
 #endif
 
-void ColemanJP04ChorusAudioProcessor::calcAlgorithmParams() {
-    wetGain = wetParam->get()/100.0;
-    dryGain = dryParam->get()/100.0;
+// Computes the per-sample increments that glide the current values to the
+// parameter targets over the next rampLength samples, or jumps straight to them
+// if glide is false. Ramps have a fixed length, so the output doesn't depend on
+// how the host splits the audio into blocks.
+// The recompute is skipped when no parameter has moved since the last one,
+// which is most blocks; at 16-32 sample buffers it would otherwise dominate.
+void ColemanJP04ChorusAudioProcessor::calcAlgorithmParams(bool glide) {
+    float values[NUM_PARAMS];
+    getParameterValues(values);
+    if (glide && std::memcmp(values, lastParamValues, sizeof(values)) == 0)
+        return;
+    std::memcpy(lastParamValues, values, sizeof(values));
+    processStats.countParamRecalc();
+    
+    wetTarget = wetParam->get()/100.0;
+    dryTarget = dryParam->get()/100.0;
+    depthTarget = calcDelaySampsFromMs((delayParam->get() - INST_DELAY_MIN)*depthParam->get()/100.0);
+    delayTarget = calcDelaySampsFromMs(delayParam->get());
+    focusTarget = focusParam->get();
+    stereoTarget = stereoParam->get();
     
+#if LFO_QUADRATURE
+    stereoLFO.setFreq(rateParam->get(), fs);
+#else
     leftLFO.setFreq(rateParam->get(), fs);
     rightLFO.setFreq(rateParam->get(), fs);
+#endif
+    
+    if (glide) {
+        wetInc = (wetTarget - wetGain)/rampLength;
+        dryInc = (dryTarget - dryGain)/rampLength;
+        depthInc = (depthTarget - sampleDepth)/rampLength;
+        delayInc = (delayTarget - sampleDelay)/rampLength;
+        focusInc = (focusTarget - focusFreq)/rampLength;
+        stereoInc = (stereoTarget - stereoOffset)/rampLength;
+        rampRemaining = rampLength;
+    }
+    else {
+        finishRamp();
+    }
+}
+
+// lands exactly on the targets, with the exact prewarp for the focus filters
+void ColemanJP04ChorusAudioProcessor::finishRamp() {
+    wetGain = wetTarget;
+    dryGain = dryTarget;
+    sampleDepth = depthTarget;
+    sampleDelay = delayTarget;
+    focusFreq = focusTarget;
+    stereoOffset = stereoTarget;
+    focusHPF.setFrequency(focusFreq);
+    setLFOPhaseOffsets();
+    wetInc = dryInc = depthInc = delayInc = focusInc = stereoInc = 0;
+    rampRemaining = 0;
+}
+
+// the left LFO leads and the right one lags by stereoOffset
+void ColemanJP04ChorusAudioProcessor::setLFOPhaseOffsets() {
+#if LFO_QUADRATURE
+    stereoLFO.setPhaseOffset(stereoOffset);
+#else
+    leftLFO.setPhaseOffset(stereoOffset);
+    rightLFO.setPhaseOffset(-1*stereoOffset);
+#endif
+}
+
+// Queues a parameter change to take effect at an exact sample, counted from
+// prepareToPlay (see getSamplePosition()). Call from one thread only, with
+// positions in order; changes at positions already processed apply at the
+// start of the next block. Returns false if the index is invalid or the queue is full.
+bool ColemanJP04ChorusAudioProcessor::queueParameterChange(int parameterIndex, float value, juce::int64 samplePos) {
+    if (parameterIndex < 0 || parameterIndex >= NUM_PARAMS || parameterIndex >= getParameters().size())
+        return false;
     
-    float coeffs[5];
-    Mu45FilterCalc::calcCoeffsHPF(coeffs, focusParam->get(), 1, fs);
-    leftHPF.setCoefficients(coeffs[0], coeffs[1], coeffs[2], coeffs[3], coeffs[4]);
-    rightHPF.setCoefficients(coeffs[0], coeffs[1], coeffs[2], coeffs[3], coeffs[4]);
+    int start1, size1, start2, size2;
+    parameterEventFifo.prepareToWrite(1, start1, size1, start2, size2);
+    if (size1 + size2 < 1)
+        return false;
     
-    sampleDepth = calcDelaySampsFromMs((delayParam->get() - INST_DELAY_MIN)*depthParam->get()/100.0);
-    sampleDelay = calcDelaySampsFromMs(delayParam->get());
+    ParameterEvent& event = parameterEvents[size1 > 0 ? start1 : start2];
+    event.samplePos = samplePos;
+    event.index = parameterIndex;
+    event.value = value;
+    parameterEventFifo.finishedWrite(1);
+    return true;
+}
+
+// Applies the queued changes due at or before samplePos, and returns the number
+// of samples from samplePos to the next queued change, at most maxSamples.
+int ColemanJP04ChorusAudioProcessor::applyParameterEvents(juce::int64 samplePos, int maxSamples) {
+    while (parameterEventFifo.getNumReady() > 0) {
+        int start1, size1, start2, size2;
+        parameterEventFifo.prepareToRead(1, start1, size1, start2, size2);
+        const ParameterEvent& event = parameterEvents[size1 > 0 ? start1 : start2];
+        if (event.samplePos > samplePos)
+            return (int) juce::jmin((juce::int64) maxSamples, event.samplePos - samplePos);
+        
+        setParameterWithoutNotifying(event.index, event.value);
+        parameterEventFifo.finishedRead(1);
+    }
+    return maxSamples;
+}
+
+// Sets a parameter as the host does, without reporting it back: a host writing
+// or touching automation would record a change reported from the audio thread
+// as a user edit. The editor still follows, as it polls the parameters.
+void ColemanJP04ChorusAudioProcessor::setParameterWithoutNotifying(int index, float value) {
+    juce::AudioProcessorParameter* param = getParameters().getUnchecked(index);
+    param->setValue(((juce::AudioParameterFloat*) param)->convertTo0to1(value));
+}
+
+// Keeps the LFOs locked to the host timeline. While the host plays straight
+// through, the LFOs just run on; when playback starts or the position jumps
+// (loop, locate, scrub, offline render in chunks), they seek to the phase
+// the new position would have at the current rate.
+void ColemanJP04ChorusAudioProcessor::syncLFOsToPlayHead(int numSamples) {
+    juce::AudioPlayHead::CurrentPositionInfo position;
+    juce::AudioPlayHead* playHead = getPlayHead();
+    if (playHead == nullptr || !playHead->getCurrentPosition(position)
+        || !position.isPlaying || position.timeInSamples < 0) {
+        nextTimelineSample = -1;
+        return;
+    }
     
-    leftLFO.setPhaseOffset(stereoParam->get());
-    rightLFO.setPhaseOffset(-1*stereoParam->get());
+    if (position.timeInSamples != nextTimelineSample) {
+        juce::uint64 sampleIndex = (juce::uint64)position.timeInSamples;
+#if LFO_QUADRATURE
+        stereoLFO.seek(sampleIndex);
+#else
+        leftLFO.seek(sampleIndex);
+        rightLFO.seek(sampleIndex);
+#endif
+    }
+    nextTimelineSample = position.timeInSamples + numSamples;
 }
 
 void ColemanJP04ChorusAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    process(buffer, midiMessages);
+}
+
+// hosts with a 64-bit mix engine call this, so the DSP (which runs in double) needs no conversion
+void ColemanJP04ChorusAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    process(buffer, midiMessages);
+}
+
+bool ColemanJP04ChorusAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+// the processing for both host sample types
+template <typename FloatType>
+void ColemanJP04ChorusAudioProcessor::process (juce::AudioBuffer<FloatType>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    uint64_t blockStartTicks = ProcessStats::now();
+    STAGE_TRACE_SCOPE("processBlock", buffer.getNumSamples());
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -208,33 +539,128 @@ void ColemanJP04ChorusAudioProcessor::processBlock (juce::AudioBuffer<float>& bu
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    calcAlgorithmParams();
+    int numSamples = buffer.getNumSamples();
+    juce::int64 blockStart = samplePosition;
+    syncLFOsToPlayHead(numSamples);
     
     auto* leftChannelData = buffer.getWritePointer(0);
     auto* rightChannelData = buffer.getWritePointer(1);
     
-    float leftSample, rightSample, leftDelayed, rightDelayed;
+    float leftMod[STAGE_BLOCK_SIZE], rightMod[STAGE_BLOCK_SIZE];
+    FloatType leftWet[STAGE_BLOCK_SIZE], rightWet[STAGE_BLOCK_SIZE];
     
-    for (int samp = 0; samp < buffer.getNumSamples(); samp++) {
-        // calculate delay length
-        leftDelayLine.setDelay(sampleDelay + leftLFO.tick()*sampleDepth);
-        rightDelayLine.setDelay(sampleDelay + rightLFO.tick()*sampleDepth);
-
-        leftSample = leftChannelData[samp];
-        rightSample = rightChannelData[samp];
-
+    // split the block at queued parameter changes, so each lands on its exact sample, and
+    // before the last sample of a glide, so a sub-block either glides throughout or not at
+    // all; then run each stage over the whole sub-block
+    int samp = 0;
+    while (samp < numSamples) {
+        int subBlockEnd;
+        bool ramping;
+        {
+            STAGE_TRACE_SCOPE("params", 0);
+            subBlockEnd = samp + applyParameterEvents(blockStart + samp, juce::jmin(numSamples - samp, STAGE_BLOCK_SIZE));
+            calcAlgorithmParams(true);
+            if (rampRemaining == 1)
+                finishRamp(); // the glide's last sample lands exactly on the targets
+            ramping = rampRemaining > 0;
+            if (ramping)
+                subBlockEnd = juce::jmin(subBlockEnd, samp + rampRemaining - 1);
+        }
+        int n = subBlockEnd - samp;
+        FloatType* left = leftChannelData + samp;
+        FloatType* right = rightChannelData + samp;
+        
+        {
+            STAGE_TRACE_SCOPE("lfo", n);
+            if (ramping && stereoInc != 0) {
+                // the phase offset glides too, so a stereo change doesn't jump the delay
+                for (int i = 0; i < n; i++) {
+                    stereoOffset += stereoInc;
+                    setLFOPhaseOffsets();
+#if LFO_QUADRATURE
+                    stereoLFO.tick(leftMod[i], rightMod[i]);
+#else
+                    leftMod[i] = leftLFO.tick();
+                    rightMod[i] = rightLFO.tick();
+#endif
+                }
+            }
+            else {
+#if LFO_QUADRATURE
+                stereoLFO.tick(leftMod, rightMod, n);
+#else
+                leftLFO.tick(leftMod, n);
+                rightLFO.tick(rightMod, n);
+#endif
+            }
+        }
+        
         // apply delays
-        leftDelayed = leftDelayLine.tick(leftSample);
-        rightDelayed = rightDelayLine.tick(rightSample);
-
+        {
+            STAGE_TRACE_SCOPE("delay", n);
+            stk::StkFloat leftDelays[STAGE_BLOCK_SIZE], rightDelays[STAGE_BLOCK_SIZE];
+            // DelayA accepts 0.5 samples up to its maximum; clamp here, where it can be counted
+            // cheaply, rather than let setDelay raise a warning from the audio thread
+            const stk::StkFloat minDelay = 0.5, maxDelay = leftDelayLine.getMaximumDelay();
+            int clamped = 0;
+            for (int i = 0; i < n; i++) {
+                if (ramping) {
+                    sampleDepth += depthInc;
+                    sampleDelay += delayInc;
+                }
+                stk::StkFloat leftDelay = sampleDelay + leftMod[i]*sampleDepth;
+                stk::StkFloat rightDelay = sampleDelay + rightMod[i]*sampleDepth;
+                leftDelays[i] = juce::jlimit(minDelay, maxDelay, leftDelay);
+                rightDelays[i] = juce::jlimit(minDelay, maxDelay, rightDelay);
+                clamped += (leftDelays[i] != leftDelay) + (rightDelays[i] != rightDelay);
+            }
+            if (clamped > 0)
+                processStats.countClampedDelays(clamped);
+            // the block ticks pick the history storage format once, not per sample
+            leftDelayLine.tick(left, leftWet, leftDelays, n);
+            rightDelayLine.tick(right, rightWet, rightDelays, n);
+        }
+        
         // apply filters
-        leftDelayed = leftHPF.tick(leftDelayed);
-        rightDelayed = rightHPF.tick(rightDelayed);
-
-        // set output
-        leftChannelData[samp] = leftSample*dryGain + rightDelayed*wetGain;
-        rightChannelData[samp] = rightSample*dryGain + leftDelayed*wetGain;
+        {
+            STAGE_TRACE_SCOPE("filter", n);
+            // both channels share the cutoff, so the glide updates it once per sample for the pair
+            if (ramping && focusInc != 0) {
+                stk::StkFloat focusFreqs[STAGE_BLOCK_SIZE];
+                for (int i = 0; i < n; i++) {
+                    focusFreq += focusInc;
+                    focusFreqs[i] = focusFreq;
+                }
+                focusHPF.tickChannels(leftWet, rightWet, focusFreqs, n);
+            }
+            else {
+                focusHPF.tickChannels(leftWet, rightWet, n);
+            }
+        }
+        
+        // set output, each wet channel crossed to the other side
+        {
+            STAGE_TRACE_SCOPE("mix", n);
+            if (ramping) {
+                for (int i = 0; i < n; i++) {
+                    wetGain += wetInc;
+                    dryGain += dryInc;
+                    FloatType leftSample = left[i];
+                    left[i] = leftSample*dryGain + rightWet[i]*wetGain;
+                    right[i] = right[i]*dryGain + leftWet[i]*wetGain;
+                }
+            }
+            else
+                DspKernels::mixCrossed(left, right, leftWet, rightWet, n, dryGain, wetGain);
+        }
+        
+        if (ramping)
+            rampRemaining -= n;
+        samp = subBlockEnd;
     }
+    
+    samplePosition = blockStart + numSamples;
+    processStats.record(blockStartTicks, numSamples);
 }
 
 //==============================================================================
@@ -249,34 +675,142 @@ juce::AudioProcessorEditor* ColemanJP04ChorusAudioProcessor::createEditor()
 }
 
 //==============================================================================
+// State layout (all integers little-endian):
+//   "MuCh" | uint16 version | uint16 count | count x (uint8 idLength, id bytes, float32 value)
+// Parameters are keyed by ID, so entries may be reordered, added or removed
+// between versions; unknown IDs are skipped on load and missing ones keep
+// their current value. Newer versions may only append data after the entries.
+// User preset files use the same layout.
 void ColemanJP04ChorusAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    juce::XmlElement xml ("Parameters");
-    for (int i = 0; i < getParameters().size(); ++i)
+    char state[STATE_MAX_BYTES];
+    float values[NUM_PARAMS];
+    getParameterValues(values);
+    destData.replaceAll(state, writeStateValues(state, values));
+}
+
+void ColemanJP04ChorusAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    float values[NUM_PARAMS];
+    getParameterValues(values);
+    if (! readStateValues(data, sizeInBytes, values))
     {
-        juce::AudioParameterFloat* param = (juce::AudioParameterFloat*)getParameters().getUnchecked(i);
-        juce::XmlElement* paramElement = new juce::XmlElement ("parameter" + juce::String(std::to_string(i)));
-        paramElement->setAttribute ("value", param->get());
-        xml.addChildElement (paramElement);
+        setStateFromLegacyXml(data, sizeInBytes); // sessions saved before the binary format
+        return;
     }
-    copyXmlToBinary (xml, destData);
+    
+    auto& params = getParameters();
+    for (int i = 0; i < NUM_PARAMS && i < params.size(); ++i)
+        *((juce::AudioParameterFloat*) params.getUnchecked(i)) = values[i];
 }
 
-void ColemanJP04ChorusAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+void ColemanJP04ChorusAudioProcessor::getParameterValues (float* values) const
+{
+    auto& params = getParameters();
+    for (int i = 0; i < NUM_PARAMS && i < params.size(); ++i)
+        values[i] = ((juce::AudioParameterFloat*) params.getUnchecked(i))->get();
+}
+
+// writes the binary state for values (in getParameters() order) into dest, returns the size
+size_t ColemanJP04ChorusAudioProcessor::writeStateValues (char* dest, const float* values) const
+{
+    auto& params = getParameters();
+    int count = juce::jmin(NUM_PARAMS, params.size());
+    
+    std::memcpy(dest, STATE_MAGIC, 4);
+    juce::uint16 version = juce::ByteOrder::swapIfBigEndian((juce::uint16) STATE_VERSION);
+    juce::uint16 count16 = juce::ByteOrder::swapIfBigEndian((juce::uint16) count);
+    std::memcpy(dest + 4, &version, 2);
+    std::memcpy(dest + 6, &count16, 2);
+    
+    size_t pos = STATE_HEADER_BYTES;
+    for (int i = 0; i < count; ++i)
+    {
+        juce::AudioParameterFloat* param = (juce::AudioParameterFloat*) params.getUnchecked(i);
+        const char* id = param->paramID.toRawUTF8();
+        size_t idLength = std::strlen(id);
+        jassert(idLength < 256 && pos + 1 + idLength + 4 <= STATE_MAX_BYTES);
+        
+        juce::uint32 bits;
+        std::memcpy(&bits, &values[i], 4);
+        bits = juce::ByteOrder::swapIfBigEndian(bits);
+        
+        dest[pos++] = (char) idLength;
+        std::memcpy(dest + pos, id, idLength);
+        pos += idLength;
+        std::memcpy(dest + pos, &bits, 4);
+        pos += 4;
+    }
+    return pos;
+}
+
+// parses binary state into values (in getParameters() order), leaving entries it
+// doesn't contain untouched; returns false if data isn't in the binary format
+bool ColemanJP04ChorusAudioProcessor::readStateValues (const void* data, int sizeInBytes, float* values) const
+{
+    const char* state = (const char*) data;
+    if (data == nullptr || sizeInBytes < STATE_HEADER_BYTES || std::memcmp(state, STATE_MAGIC, 4) != 0)
+        return false;
+    
+    auto& params = getParameters();
+    int count = juce::ByteOrder::littleEndianShort(state + 6);
+    int pos = STATE_HEADER_BYTES;
+    for (int entry = 0; entry < count; ++entry)
+    {
+        if (pos + 1 > sizeInBytes)
+            break; // truncated
+        int idLength = (juce::uint8) state[pos++];
+        if (pos + idLength + 4 > sizeInBytes)
+            break;
+        const char* id = state + pos;
+        pos += idLength;
+        juce::uint32 bits = juce::ByteOrder::littleEndianInt(state + pos);
+        pos += 4;
+        
+        for (int i = 0; i < NUM_PARAMS && i < params.size(); ++i)
+        {
+            const char* paramID = ((juce::AudioParameterFloat*) params.getUnchecked(i))->paramID.toRawUTF8();
+            if ((int) std::strlen(paramID) == idLength && std::memcmp(paramID, id, idLength) == 0)
+            {
+                std::memcpy(&values[i], &bits, 4);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+void ColemanJP04ChorusAudioProcessor::setStateFromLegacyXml (const void* data, int sizeInBytes)
 {
     std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
-    if (xmlState->hasTagName ("Parameters")) // read Parameters tag
+    if (xmlState != nullptr && xmlState->hasTagName ("Parameters")) // read Parameters tag
     {
         juce::AudioParameterFloat* param;
         for (auto* element : xmlState->getChildIterator()) // loop through the saved parameter values and update them
         {
-            int paramNum = std::stoi(element->getTagName().substring(9).toStdString()); // chops off beginnging "parameter"
+            if (! element->getTagName().startsWith("parameter"))
+                continue;
+            int paramNum = element->getTagName().substring(9).getIntValue(); // chops off beginnging "parameter"
+            if (paramNum < 0 || paramNum >= getParameters().size())
+                continue;
             param = (juce::AudioParameterFloat*) getParameters().getUnchecked(paramNum);
             *param = element->getDoubleAttribute("value"); // set parameter value
         }
     }
 }
 
+ProcessStatsSnapshot ColemanJP04ChorusAudioProcessor::getProcessStats() const
+{
+    return processStats.snapshot();
+}
+
+size_t ColemanJP04ChorusAudioProcessor::getMemoryFootprint() const
+{
+    return sizeof(*this)
+        + focusHPF.heapBytes()
+        + leftDelayLine.heapBytes() + rightDelayLine.heapBytes();
+}
+
 //==============================================================================
 // This creates new instances of the plugin..
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
@@ -10,10 +10,13 @@
 
 #include <JuceHeader.h>
 #include "Mu45LFO/Mu45LFO.h"
-#include "Mu45FilterCalc/Mu45FilterCalc.h"
+#include "Mu45LFO/Mu45QuadLFO.h"
 #include "StkLite-4.6.1/DelayA.h"
-#include "StkLite-4.6.1/BiQuad.h"
+#include "StkLite-4.6.1/SVF.h"
 #include "Defines.h"
+#include "DspKernels.h"
+#include "ProcessStats.h"
+#include "StageTrace.h"
 
 //==============================================================================
 /**
@@ -34,6 +37,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -57,6 +62,26 @@ public:
     //==============================================================================
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
+    
+    // bytes used by this instance's DSP state, including delay line buffers
+    size_t getMemoryFootprint() const;
+    
+    // store the current parameters as a user program, on disk and in the bank,
+    // replacing the user program of the same name if there is one
+    bool saveUserPreset(const juce::String& name);
+    
+    // number of STK warnings (e.g. clamped delays) reported by this instance's DSP objects
+    int getStkWarningCount() const { return stkWarnings; }
+    
+    // sample-accurate automation: the change lands on sample samplePos of the processed stream,
+    // and isn't reported back to the host as an edit
+    bool queueParameterChange(int parameterIndex, float value, juce::int64 samplePos);
+    
+    // samples processed since prepareToPlay, the clock queueParameterChange() positions use
+    juce::int64 getSamplePosition() const { return samplePosition; }
+    
+    // block timing and counters, safe to call from any thread (all zero if PROCESS_STATS is 0)
+    ProcessStatsSnapshot getProcessStats() const;
 
 private:
     //==============================================================================
@@ -70,24 +95,99 @@ private:
     juce::AudioParameterFloat* stereoParam; // relative phase of left and right LFO
     juce::AudioParameterFloat* delayParam; // center point of delay in ms
     
-    // "focus" high pass filters
-    stk::BiQuad leftHPF;
-    stk::BiQuad rightHPF;
+    // sample rate and error sink for this instance's STK objects, so instances
+    // running on different threads or rates don't share the STK globals
+    stk::StkContext stkContext;
+    std::atomic<int> stkWarnings;
+    
+    // "focus" high pass filter, run on both channels at once with their own states
+    stk::SVF focusHPF;
     
     // delay LFOs
+#if LFO_QUADRATURE
+    Mu45QuadLFO stereoLFO; // both channels from one oscillator
+#else
     Mu45LFO leftLFO;
     Mu45LFO rightLFO;
+#endif
     
-    // interpolating delay lines
-    stk::DelayA leftDelayLine;
-    stk::DelayA rightDelayLine;
+    // interpolating delay lines, created with the smallest history and sized in prepareToPlay,
+    // so an instance costs next to nothing until the host actually uses it
+    stk::DelayA leftDelayLine { 0.5, 1 };
+    stk::DelayA rightDelayLine { 0.5, 1 };
     
     float fs; // sampling rate
     float wetGain; // linear wet gain
     float dryGain; // linear dry gain
     float sampleDepth; // depth of LFO in number of samples
     float sampleDelay; // midpoint delay of LFO in number of samples
+    float focusFreq; // current focus cutoff in Hz
+    float focusInc; // per-sample focus glide toward focusParam in Hz
+    juce::int64 nextTimelineSample; // host position expected at the next block, -1 when not playing
+    
+    // fixed-length glides toward the parameter values, so jumps (e.g. program changes) don't click
+    float wetTarget;
+    float dryTarget;
+    float depthTarget;
+    float delayTarget;
+    float focusTarget;
+    float stereoTarget;
+    float stereoOffset; // current LFO phase offset in degrees, gliding toward stereoParam
+    float wetInc;
+    float dryInc;
+    float depthInc;
+    float delayInc;
+    float stereoInc;
+    int rampLength; // glide length in samples, PARAM_RAMP_MS at the current rate
+    int rampRemaining; // samples left in the current glide
+    float lastParamValues[NUM_PARAMS]; // in getParameters() order, as of the last recompute
+    
+    // parameter changes queued for exact samples, oldest first
+    struct ParameterEvent {
+        juce::int64 samplePos;
+        int index; // in getParameters() order
+        float value;
+    };
+    ParameterEvent parameterEvents[PARAM_EVENT_QUEUE_SIZE];
+    juce::AbstractFifo parameterEventFifo { PARAM_EVENT_QUEUE_SIZE };
+    std::atomic<juce::int64> samplePosition;
+    
+    ProcessStats processStats;
+    
+    // Program bank shared by every instance in the process: the factory presets followed by
+    // the user presets on disk, read once, on first use. An entry is never changed in place;
+    // saving or renaming publishes a complete new one, so a reader on any thread sees an
+    // entry from before or after the change, never a mix of the two.
+    struct Program {
+        char name[PRESET_NAME_LENGTH];
+        float values[NUM_PARAMS]; // in getParameters() order
+    };
+    struct ProgramBank {
+        explicit ProgramBank(const ColemanJP04ChorusAudioProcessor& reader);
+        const Program* add(const Program& program);
+        
+        std::atomic<const Program*> entries[MAX_PROGRAMS];
+        std::atomic<int> numPrograms;
+        juce::CriticalSection writeLock; // held while publishing, never by readers
+        juce::OwnedArray<Program> storage; // every entry published, as a reader may still hold a replaced one
+    };
+    std::atomic<int> currentProgram;
 
-    void calcAlgorithmParams();
+    static void handleStkError(const std::string& message, stk::StkError::Type type, void* processor);
+    template <typename FloatType>
+    void process(juce::AudioBuffer<FloatType>& buffer, juce::MidiBuffer& midiMessages);
+    void resetState();
+    void calcAlgorithmParams(bool glide);
+    void finishRamp();
+    void setLFOPhaseOffsets();
+    int applyParameterEvents(juce::int64 samplePos, int maxSamples);
+    void setParameterWithoutNotifying(int index, float value);
+    void syncLFOsToPlayHead(int numSamples);
+    ProgramBank& getProgramBank() const;
+    static juce::File getUserPresetDirectory();
+    void getParameterValues(float* values) const;
+    size_t writeStateValues(char* dest, const float* values) const;
+    bool readStateValues(const void* data, int sizeInBytes, float* values) const;
+    void setStateFromLegacyXml(const void* data, int sizeInBytes);
     float calcDelaySampsFromMs(float ms){ return std::ceil(ms*(fs/1000.0)); }
 };
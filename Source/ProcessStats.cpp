@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    ProcessStats.cpp
+    Lock-free processing statistics for one plugin instance.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ProcessStats.h"
+
+#if PROCESS_STATS
+
+#include <algorithm>
+#include <cmath>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+ProcessStats::ProcessStats()
+{
+    startTicks = now();
+    startClockTicks = juce::Time::getHighResolutionTicks();
+    clear();
+    sampleRate = 44100;
+    deadlineTicksPerSample = -1; // overruns are counted from the first reset()
+}
+
+void ProcessStats::reset(double rate)
+{
+    clear();
+    sampleRate = rate;
+    deadlineTicksPerSample = ticksPerMicro()*1e6/rate; // 0 if too early to tell, then record() calibrates
+}
+
+void ProcessStats::clear()
+{
+    sequence = 0;
+    blocks = 0;
+    samples = 0;
+    totalTicks = 0;
+    minTicks = UINT64_MAX;
+    maxTicks = 0;
+    for (int i = 0; i < NUM_BINS; i++)
+        bins[i] = 0;
+    paramRecalcs = 0;
+    clampedDelays = 0;
+    overruns = 0;
+    peakLoad = 0;
+}
+
+uint64_t ProcessStats::now()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return (uint64_t) juce::Time::getHighResolutionTicks();
+#endif
+}
+
+// bins 0-3 hold 0-3 ticks, then four bins per octave
+int ProcessStats::binFor(uint64_t ticks)
+{
+    if (ticks < 4)
+        return (int) ticks;
+    int octave = 0;
+    for (uint64_t t = ticks; t > 1; t >>= 1)
+        octave++;
+    return octave*4 + (int) ((ticks >> (octave - 2)) & 3);
+}
+
+double ProcessStats::binUpperEdge(int bin)
+{
+    if (bin < 4)
+        return bin + 1;
+    int octave = bin/4;
+    return std::ldexp(5.0 + bin%4, octave - 2);
+}
+
+// ticks per microsecond, measured against JUCE's clock over this object's
+// lifetime; 0 during its first millisecond, too short to measure well
+double ProcessStats::ticksPerMicro() const
+{
+    double micros = (juce::Time::getHighResolutionTicks() - startClockTicks)*1e6
+                    / juce::Time::getHighResolutionTicksPerSecond();
+    if (micros < 1000)
+        return 0;
+    double ticks = (now() - startTicks)/micros;
+    return ticks > 0 ? ticks : 0;
+}
+
+// upper edge of the bin holding the rank-th smallest block, capped at the maximum
+double ProcessStats::percentileTicks(const uint64_t* counts, uint64_t rank, uint64_t maxTicks)
+{
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BINS; i++) {
+        seen += counts[i];
+        if (seen >= rank)
+            return std::min(binUpperEdge(i), (double) maxTicks);
+    }
+    return (double) maxTicks;
+}
+
+void ProcessStats::record(uint64_t start, int numSamples)
+{
+    uint64_t ticks = now() - start;
+    const std::memory_order relaxed = std::memory_order_relaxed;
+    
+    // prepared within a millisecond of construction: calibrate once the clock allows
+    double ticksPerSample = deadlineTicksPerSample.load(relaxed);
+    if (ticksPerSample == 0) {
+        ticksPerSample = ticksPerMicro()*1e6/sampleRate.load(relaxed);
+        deadlineTicksPerSample.store(ticksPerSample, relaxed);
+    }
+    
+    uint32_t seq = sequence.load(relaxed);
+    sequence.store(seq + 1, relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    blocks.store(blocks.load(relaxed) + 1, relaxed);
+    samples.store(samples.load(relaxed) + numSamples, relaxed);
+    totalTicks.store(totalTicks.load(relaxed) + ticks, relaxed);
+    if (ticks < minTicks.load(relaxed)) minTicks.store(ticks, relaxed);
+    if (ticks > maxTicks.load(relaxed)) maxTicks.store(ticks, relaxed);
+    std::atomic<uint64_t>& bin = bins[binFor(ticks)];
+    bin.store(bin.load(relaxed) + 1, relaxed);
+    double deadline = numSamples*ticksPerSample;
+    if (deadline > 0) {
+        double blockLoad = ticks/deadline;
+        if (blockLoad > 1) overruns.store(overruns.load(relaxed) + 1, relaxed);
+        if (blockLoad > peakLoad.load(relaxed)) peakLoad.store(blockLoad, relaxed);
+    }
+    
+    sequence.store(seq + 2, std::memory_order_release);
+}
+
+ProcessStatsSnapshot ProcessStats::snapshot() const
+{
+    const std::memory_order relaxed = std::memory_order_relaxed;
+    ProcessStatsSnapshot s;
+    uint64_t total, minT, maxT, counts[NUM_BINS];
+    uint32_t before, after;
+    do {
+        before = sequence.load(std::memory_order_acquire);
+        s.blocks = blocks.load(relaxed);
+        s.samples = samples.load(relaxed);
+        total = totalTicks.load(relaxed);
+        minT = minTicks.load(relaxed);
+        maxT = maxTicks.load(relaxed);
+        for (int i = 0; i < NUM_BINS; i++)
+            counts[i] = bins[i].load(relaxed);
+        s.overruns = overruns.load(relaxed);
+        s.peakLoad = peakLoad.load(relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = sequence.load(relaxed);
+    } while ((before & 1) || before != after);
+    s.paramRecalcs = paramRecalcs.load(relaxed);
+    s.clampedDelays = clampedDelays.load(relaxed);
+    
+    double tpm = ticksPerMicro();
+    if (s.blocks == 0 || tpm == 0)
+        return s;
+    
+    s.minMicros = minT/tpm;
+    s.maxMicros = maxT/tpm;
+    s.meanMicros = total/tpm/s.blocks;
+    s.p99Micros = percentileTicks(counts, s.blocks - s.blocks/100, maxT)/tpm;
+    s.p999Micros = percentileTicks(counts, s.blocks - s.blocks/1000, maxT)/tpm;
+    
+    double realMicros = s.samples*1e6/sampleRate.load(relaxed);
+    s.load = realMicros > 0 ? total/tpm/realMicros : 0;
+    return s;
+}
+
+#endif
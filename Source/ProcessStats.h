@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    ProcessStats.h
+    Lock-free processing statistics for one plugin instance.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "Defines.h"
+
+// what the editor (or anything else off the audio thread) sees
+struct ProcessStatsSnapshot {
+    uint64_t blocks = 0;        // processBlock calls recorded
+    uint64_t samples = 0;       // samples processed by those calls
+    uint64_t paramRecalcs = 0;  // times the parameters were actually recomputed
+    uint64_t clampedDelays = 0; // modulated delays clamped to the delay lines' range
+    double minMicros = 0;       // block times
+    double meanMicros = 0;
+    double maxMicros = 0;
+    double p99Micros = 0;       // upper edge of the quarter-octave bin holding the 99th percentile
+    double p999Micros = 0;      // likewise for the 99.9th percentile
+    double load = 0;            // processing time / real time of the audio processed
+    double peakLoad = 0;        // the same for the worst single block
+    uint64_t overruns = 0;      // blocks that took longer than the audio they produced
+};
+
+#if PROCESS_STATS
+
+// The audio thread times each block with the CPU's cycle counter and records
+// it with plain relaxed stores (it is the only writer). Other threads read a
+// consistent copy through snapshot(), which retries if a block was recorded
+// while it was copying (a sequence lock), so neither side ever waits.
+class ProcessStats {
+public:
+    ProcessStats();
+    
+    void reset(double sampleRate);  // only while the audio thread is not recording
+    
+    static uint64_t now();          // cycle counter, the start time for record()
+    void record(uint64_t startTicks, int numSamples);
+    void countParamRecalc() { paramRecalcs.store(paramRecalcs.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+    void countClampedDelays(int count) { clampedDelays.store(clampedDelays.load(std::memory_order_relaxed) + count, std::memory_order_relaxed); }
+    
+    ProcessStatsSnapshot snapshot() const;
+    
+private:
+    static const int NUM_BINS = 256; // quarter octaves of ticks
+    void clear();
+    static int binFor(uint64_t ticks);
+    static double binUpperEdge(int bin);
+    static double percentileTicks(const uint64_t* counts, uint64_t rank, uint64_t maxTicks);
+    double ticksPerMicro() const;
+    
+    std::atomic<uint32_t> sequence; // odd while record() is writing
+    std::atomic<uint64_t> blocks;
+    std::atomic<uint64_t> samples;
+    std::atomic<uint64_t> totalTicks;
+    std::atomic<uint64_t> minTicks;
+    std::atomic<uint64_t> maxTicks;
+    std::atomic<uint64_t> bins[NUM_BINS];
+    std::atomic<uint64_t> paramRecalcs;
+    std::atomic<uint64_t> clampedDelays;
+    std::atomic<uint64_t> overruns;
+    std::atomic<double> peakLoad;
+    
+    // cycle counter calibration against juce::Time's high resolution clock
+    uint64_t startTicks;
+    int64_t startClockTicks;
+    std::atomic<double> sampleRate;
+    std::atomic<double> deadlineTicksPerSample; // real time of one sample in ticks, 0 until calibrated, -1 before reset()
+};
+
+#else
+
+// compiled out: every call is an empty inline the optimizer removes
+class ProcessStats {
+public:
+    void reset(double) {}
+    static uint64_t now() { return 0; }
+    void record(uint64_t, int) {}
+    void countParamRecalc() {}
+    void countClampedDelays(int) {}
+    ProcessStatsSnapshot snapshot() const { return ProcessStatsSnapshot(); }
+};
+
+#endif
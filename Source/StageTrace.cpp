@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+    StageTrace.cpp
+    Scoped timing markers for the stages of processBlock.
+
+  ==============================================================================
+*/
+
+#include "StageTrace.h"
+
+#if STAGE_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+struct Record {
+    const char* name;
+    int samples;
+    int64_t startNanos;
+    int64_t endNanos;
+};
+
+// one per recording thread, in static storage so recording never allocates
+struct Ring {
+    std::atomic<uint64_t> written; // records appended so far, including overwritten ones
+    Record records[STAGE_TRACE_RING_SIZE];
+};
+
+Ring rings[STAGE_TRACE_THREADS];
+std::atomic<int> ringsClaimed(0);
+
+// this thread's index into rings: -1 until its first record, then
+// STAGE_TRACE_THREADS if every ring was already taken (its records are dropped)
+thread_local int threadRing = -1;
+
+}
+
+int64_t StageTrace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void StageTrace::append(const Scope& scope)
+{
+    int64_t end = now();
+
+    if (threadRing < 0) {
+        int claimed = ringsClaimed.fetch_add(1, std::memory_order_relaxed);
+        threadRing = claimed < STAGE_TRACE_THREADS ? claimed : STAGE_TRACE_THREADS;
+    }
+    if (threadRing == STAGE_TRACE_THREADS)
+        return;
+
+    Ring& ring = rings[threadRing];
+    uint64_t n = ring.written.load(std::memory_order_relaxed);
+    Record& r = ring.records[n & (STAGE_TRACE_RING_SIZE - 1)];
+    r.name = scope.name;
+    r.samples = scope.samples;
+    r.startNanos = scope.start;
+    r.endNanos = end;
+    ring.written.store(n + 1, std::memory_order_release);
+}
+
+// complete ("X") events with times in microseconds from the earliest record,
+// one trace thread per ring
+std::string StageTrace::toChromeJson()
+{
+    int numRings = ringsClaimed.load(std::memory_order_relaxed);
+    if (numRings > STAGE_TRACE_THREADS)
+        numRings = STAGE_TRACE_THREADS;
+
+    uint64_t written[STAGE_TRACE_THREADS];
+    int64_t origin = INT64_MAX;
+    for (int t = 0; t < numRings; t++) {
+        written[t] = rings[t].written.load(std::memory_order_acquire);
+        uint64_t first = written[t] > STAGE_TRACE_RING_SIZE ? written[t] - STAGE_TRACE_RING_SIZE : 0;
+        if (written[t] > first) {
+            int64_t start = rings[t].records[first & (STAGE_TRACE_RING_SIZE - 1)].startNanos;
+            if (start < origin)
+                origin = start;
+        }
+    }
+
+    std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    char event[256];
+    bool firstEvent = true;
+    for (int t = 0; t < numRings; t++) {
+        std::snprintf(event, sizeof(event),
+                      "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                      firstEvent ? "" : ",", t, t);
+        json += event;
+        firstEvent = false;
+
+        uint64_t first = written[t] > STAGE_TRACE_RING_SIZE ? written[t] - STAGE_TRACE_RING_SIZE : 0;
+        for (uint64_t i = first; i < written[t]; i++) {
+            const Record& r = rings[t].records[i & (STAGE_TRACE_RING_SIZE - 1)];
+            std::snprintf(event, sizeof(event),
+                          ",\n{\"name\":\"%s\",\"cat\":\"process\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"samples\":%d}}",
+                          r.name, t, (r.startNanos - origin)/1000.0, (r.endNanos - r.startNanos)/1000.0, r.samples);
+            json += event;
+        }
+    }
+    json += "\n]}\n";
+    return json;
+}
+
+// one row per stage name, in order of first appearance
+std::string StageTrace::summary()
+{
+    const int maxStages = 32;
+    struct Stage {
+        const char* name;
+        uint64_t calls;
+        uint64_t samples;
+        int64_t nanos;
+    } stages[maxStages];
+    int numStages = 0;
+
+    int numRings = ringsClaimed.load(std::memory_order_relaxed);
+    for (int t = 0; t < numRings && t < STAGE_TRACE_THREADS; t++) {
+        uint64_t written = rings[t].written.load(std::memory_order_acquire);
+        uint64_t first = written > STAGE_TRACE_RING_SIZE ? written - STAGE_TRACE_RING_SIZE : 0;
+        for (uint64_t i = first; i < written; i++) {
+            const Record& r = rings[t].records[i & (STAGE_TRACE_RING_SIZE - 1)];
+            int s = 0;
+            while (s < numStages && std::strcmp(stages[s].name, r.name) != 0)
+                s++;
+            if (s == numStages) {
+                if (numStages == maxStages)
+                    continue;
+                std::memset(&stages[s], 0, sizeof(Stage));
+                stages[s].name = r.name;
+                numStages++;
+            }
+            Stage& stage = stages[s];
+            stage.calls++;
+            stage.samples += r.samples;
+            stage.nanos += r.endNanos - r.startNanos;
+        }
+    }
+
+    // costs are per sample, or per call for stages that process no samples
+    std::string table;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-14s %10s %12s %10s\n", "stage", "calls", "samples", "ns");
+    table += line;
+    for (int s = 0; s < numStages; s++) {
+        const Stage& stage = stages[s];
+        double per = stage.samples > 0 ? (double) stage.samples : (double) stage.calls;
+        std::snprintf(line, sizeof(line), "%-14s %10llu %12llu %10.2f\n", stage.name,
+                      (unsigned long long) stage.calls, (unsigned long long) stage.samples, stage.nanos/per);
+        table += line;
+    }
+    return table;
+}
+
+void StageTrace::clear()
+{
+    int numRings = ringsClaimed.load(std::memory_order_relaxed);
+    for (int t = 0; t < numRings && t < STAGE_TRACE_THREADS; t++)
+        rings[t].written.store(0, std::memory_order_relaxed);
+}
+
+#endif
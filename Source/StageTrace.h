@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    StageTrace.h
+    Scoped timing markers for the stages of processBlock.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "Defines.h"
+
+#if STAGE_TRACE
+
+// STAGE_TRACE_SCOPE("name", numSamples) times the rest of the enclosing scope
+// and, when the scope ends, appends one fixed-size record to the calling
+// thread's ring. A ring has a single writer, its thread, and is never locked or
+// resized; once full, the oldest records are overwritten. Only the name pointer
+// is stored, so names must be string literals. numSamples is the audio the
+// scope processes (0 if none), so costs can be given per sample. A scope
+// that encloses others (processBlock) includes their recording, about two
+// clock reads and a ring write each. Hardware counters per kernel are in the
+// "counters" benchmark (Benchmarks/), not here.
+class StageTrace {
+public:
+    class Scope {
+    public:
+        Scope(const char* stageName, int numSamples) : name(stageName), samples(numSamples), start(now()) {}
+        ~Scope() { append(*this); }
+    private:
+        friend class StageTrace;
+        const char* name;
+        int samples;
+        int64_t start;
+    };
+
+    static int64_t now();   // steady clock, in nanoseconds
+
+    // Every thread's records as Chrome trace JSON, which Perfetto also opens,
+    // and as a table of each stage's mean cost per sample. Records written
+    // meanwhile may come out torn, so call these only while nothing is processing.
+    static std::string toChromeJson();
+    static std::string summary();
+    static void clear();
+
+private:
+    static void append(const Scope& scope);
+};
+
+#define STAGE_TRACE_SCOPE(name, numSamples) StageTrace::Scope stageTraceScope (name, numSamples)
+
+#else
+
+// compiled out: the markers expand to nothing
+#define STAGE_TRACE_SCOPE(name, numSamples)
+
+#endif
@@ -54,7 +54,7 @@ void BiQuad :: sampleRateChanged( StkFloat newRate, StkFloat oldRate )
 void BiQuad :: setResonance( StkFloat frequency, StkFloat radius, bool normalize )
 {
 #if defined(_STK_DEBUG_)
-  if ( frequency < 0.0 || frequency > 0.5 * Stk::sampleRate() ) {
+  if ( frequency < 0.0 || frequency > 0.5 * contextSampleRate() ) {
     oStream_ << "BiQuad::setResonance: frequency argument (" << frequency << ") is out of range!";
     handleError( StkError::WARNING ); return;
   }
@@ -65,7 +65,7 @@ void BiQuad :: setResonance( StkFloat frequency, StkFloat radius, bool normalize
 #endif
 
   a_[2] = radius * radius;
-  a_[1] = -2.0 * radius * cos( TWO_PI * frequency / Stk::sampleRate() );
+  a_[1] = -2.0 * radius * cos( TWO_PI * frequency / contextSampleRate() );
 
   if ( normalize ) {
     // Use zeros at +- 1 and normalize the filter peak gain.
@@ -78,7 +78,7 @@ void BiQuad :: setResonance( StkFloat frequency, StkFloat radius, bool normalize
 void BiQuad :: setNotch( StkFloat frequency, StkFloat radius )
 {
 #if defined(_STK_DEBUG_)
-  if ( frequency < 0.0 || frequency > 0.5 * Stk::sampleRate() ) {
+  if ( frequency < 0.0 || frequency > 0.5 * contextSampleRate() ) {
     oStream_ << "BiQuad::setNotch: frequency argument (" << frequency << ") is out of range!";
     handleError( StkError::WARNING ); return;
   }
@@ -90,7 +90,7 @@ void BiQuad :: setNotch( StkFloat frequency, StkFloat radius )
 
   // This method does not attempt to normalize the filter gain.
   b_[2] = radius * radius;
-  b_[1] = (StkFloat) -2.0 * radius * cos( TWO_PI * (double) frequency / Stk::sampleRate() );
+  b_[1] = (StkFloat) -2.0 * radius * cos( TWO_PI * (double) frequency / contextSampleRate() );
 }
 
 void BiQuad :: setEqualGainZeroes( void )
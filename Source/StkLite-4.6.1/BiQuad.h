@@ -111,6 +111,28 @@ public:
   */
   StkFrames& tick( StkFrames& iFrames, StkFrames &oFrames, unsigned int iChannel = 0, unsigned int oChannel = 0 );
 
+  //! Take a channel of the StkFrameView as inputs to the filter and replace with corresponding outputs.
+  /*!
+    The StkFrameView argument reference is returned.  This works as
+    the StkFrames version, but on float data in place, for example
+    a channel of a host audio buffer.  The \c channel argument must
+    be less than the number of channels in the view.  However, range
+    checking is only performed if _STK_DEBUG_ is defined during
+    compilation, in which case an out-of-range value will trigger an
+    StkError exception.
+  */
+  StkFrameView& tick( StkFrameView& frames, unsigned int channel = 0 );
+
+  //! Take a channel of the \c iFrames view as inputs to the filter and write outputs to the \c oFrames view.
+  /*!
+    The \c iFrames view reference is returned.  Each channel argument
+    must be less than the number of channels in the corresponding
+    view.  However, range checking is only performed if _STK_DEBUG_
+    is defined during compilation, in which case an out-of-range value
+    will trigger an StkError exception.
+  */
+  StkFrameView& tick( StkFrameView& iFrames, StkFrameView &oFrames, unsigned int iChannel = 0, unsigned int oChannel = 0 );
+
  protected:
 
   virtual void sampleRateChanged( StkFloat newRate, StkFloat oldRate );
@@ -180,6 +202,59 @@ inline StkFrames& BiQuad :: tick( StkFrames& iFrames, StkFrames& oFrames, unsign
   return iFrames;
 }
 
+inline StkFrameView& BiQuad :: tick( StkFrameView& frames, unsigned int channel )
+{
+#if defined(_STK_DEBUG_)
+  if ( channel >= frames.channels() ) {
+    oStream_ << "BiQuad::tick(): channel and StkFrameView arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  float *samples = frames.channel( channel );
+  unsigned int hop = frames.stride();
+  for ( unsigned int i=0; i<frames.frames(); i++, samples += hop ) {
+    inputs_[0] = gain_ * *samples;
+    outputs_[0] = b_[0] * inputs_[0] + b_[1] * inputs_[1] + b_[2] * inputs_[2];
+    outputs_[0] -= a_[2] * outputs_[2] + a_[1] * outputs_[1];
+    inputs_[2] = inputs_[1];
+    inputs_[1] = inputs_[0];
+    outputs_[2] = outputs_[1];
+    outputs_[1] = outputs_[0];
+    *samples = (float) outputs_[0];
+  }
+
+  lastFrame_[0] = outputs_[1];
+  return frames;
+}
+
+inline StkFrameView& BiQuad :: tick( StkFrameView& iFrames, StkFrameView& oFrames, unsigned int iChannel, unsigned int oChannel )
+{
+#if defined(_STK_DEBUG_)
+  if ( iChannel >= iFrames.channels() || oChannel >= oFrames.channels() ) {
+    oStream_ << "BiQuad::tick(): channel and StkFrameView arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  float *iSamples = iFrames.channel( iChannel );
+  float *oSamples = oFrames.channel( oChannel );
+  unsigned int iHop = iFrames.stride(), oHop = oFrames.stride();
+  for ( unsigned int i=0; i<iFrames.frames(); i++, iSamples += iHop, oSamples += oHop ) {
+    inputs_[0] = gain_ * *iSamples;
+    outputs_[0] = b_[0] * inputs_[0] + b_[1] * inputs_[1] + b_[2] * inputs_[2];
+    outputs_[0] -= a_[2] * outputs_[2] + a_[1] * outputs_[1];
+    inputs_[2] = inputs_[1];
+    inputs_[1] = inputs_[0];
+    outputs_[2] = outputs_[1];
+    outputs_[1] = outputs_[0];
+    *oSamples = (float) outputs_[0];
+  }
+
+  lastFrame_[0] = outputs_[1];
+  return iFrames;
+}
+
 } // stk namespace
 
 #endif
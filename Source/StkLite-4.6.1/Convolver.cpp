@@ -0,0 +1,245 @@
+/***************************************************/
+/*! \class Convolver
+    \brief STK finite impulse response filter for long impulse responses.
+
+    This class computes the Fir difference equation either in direct
+    form or as a direct-form head plus uniformly-partitioned FFT
+    convolution of the tail, choosing the cheaper form for the
+    filter length and host block size.
+*/
+/***************************************************/
+
+#include "Convolver.h"
+#include <cmath>
+
+namespace stk {
+
+// Partition sizes considered by the automatic choice.
+static const unsigned int MIN_PARTITION = 16;
+static const unsigned int MAX_PARTITION = 1024;
+
+Convolver :: Convolver()
+  : mode_( AUTOMATIC ), blockSize_( RT_BUFFER_SIZE ),
+    partitionSize_( 0 ), partitions_( 0 ), blockIndex_( 0 ), fdlIndex_( 0 )
+{
+  // The default constructor should setup for pass-through.
+  b_.push_back( 1.0 );
+  this->configure();
+}
+
+Convolver :: Convolver( std::vector<StkFloat> &coefficients, unsigned int blockSize )
+  : mode_( AUTOMATIC ), blockSize_( blockSize ),
+    partitionSize_( 0 ), partitions_( 0 ), blockIndex_( 0 ), fdlIndex_( 0 )
+{
+  // Check the arguments.
+  if ( coefficients.size() == 0 ) {
+    oStream_ << "Convolver: coefficient vector must have size > 0!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+
+  gain_ = 1.0;
+  b_ = coefficients;
+  this->configure();
+}
+
+Convolver :: ~Convolver()
+{
+}
+
+void Convolver :: setCoefficients( std::vector<StkFloat> &coefficients )
+{
+  // Check the argument.
+  if ( coefficients.size() == 0 ) {
+    oStream_ << "Convolver::setCoefficients: coefficient vector must have size > 0!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+
+  b_ = coefficients;
+  this->configure();
+}
+
+void Convolver :: setBlockSize( unsigned int blockSize )
+{
+  if ( blockSize == 0 ) {
+    oStream_ << "Convolver::setBlockSize: argument must be greater than zero!";
+    handleError( StkError::WARNING ); return;
+  }
+
+  if ( blockSize == blockSize_ ) return;
+  blockSize_ = blockSize;
+  this->configure();
+}
+
+void Convolver :: setMode( Mode mode )
+{
+  mode_ = mode;
+  this->configure();
+}
+
+void Convolver :: configure( void )
+{
+  size_t length = b_.size();
+
+  // Estimated cost per output sample, in (vectorized) multiply-adds.
+  // Direct form costs one per coefficient.  Partitioned form costs the
+  // direct head, two FFTs of size 2B every B samples, and a complex
+  // multiply-add per half-spectrum bin and partition every B samples.
+  StkFloat directCost = (StkFloat) length;
+  StkFloat bestCost = 0.0;
+  unsigned int bestSize = 0;
+
+  unsigned int maxSize = MIN_PARTITION;
+  while ( maxSize < blockSize_ && maxSize < MAX_PARTITION ) maxSize <<= 1;
+
+  for ( unsigned int size = MIN_PARTITION; size <= maxSize; size <<= 1 ) {
+    if ( size >= length && mode_ != PARTITIONED ) break;
+    size_t count = ( length > size ) ? ( length - size + size - 1 ) / size : 0;
+    StkFloat cost = size + 20.0 * std::log( 2.0 * size ) / std::log( 2.0 ) + 8.0 * count;
+    if ( bestSize == 0 || cost < bestCost ) {
+      bestCost = cost;
+      bestSize = size;
+    }
+  }
+
+  bool partitioned = false;
+  if ( mode_ == PARTITIONED ) partitioned = bestSize > 0;
+  else if ( mode_ == AUTOMATIC ) partitioned = bestSize > 0 && bestCost < directCost;
+
+  partitionSize_ = partitioned ? bestSize : 0;
+  partitions_ = 0;
+  if ( partitioned && length > partitionSize_ )
+    partitions_ = (unsigned int) ( ( length - partitionSize_ + partitionSize_ - 1 ) / partitionSize_ );
+
+  // Direct form runs the whole filter, or the first B coefficients
+  // when partitioned.
+  size_t headLength = ( partitionSize_ > 0 && partitionSize_ < length ) ? partitionSize_ : length;
+  std::vector<StkFloat> head( b_.begin(), b_.begin() + headLength );
+  head_.setCoefficients( head, true );
+
+  if ( partitions_ == 0 ) {
+    inputBlock_.clear();
+    tailOut_.clear();
+    spectra_.clear();
+    fdl_.clear();
+    work_.clear();
+    twiddles_.clear();
+    bitReverse_.clear();
+    this->clear();
+    return;
+  }
+
+  unsigned int B = partitionSize_, M = 2 * B, bins = B + 1;
+  inputBlock_.assign( 2 * B, 0.0 );
+  tailOut_.assign( B, 0.0 );
+  fdl_.assign( (size_t) partitions_ * bins, Complex( 0.0, 0.0 ) );
+  work_.assign( M, Complex( 0.0, 0.0 ) );
+
+  twiddles_.resize( M / 2 );
+  for ( unsigned int i=0; i<M/2; i++ )
+    twiddles_[i] = Complex( std::cos( TWO_PI * i / M ), -std::sin( TWO_PI * i / M ) );
+
+  unsigned int bits = 0;
+  while ( ( 1u << bits ) < M ) bits++;
+  bitReverse_.resize( M );
+  for ( unsigned int i=0; i<M; i++ ) {
+    unsigned int r = 0;
+    for ( unsigned int j=0; j<bits; j++ )
+      if ( i & ( 1u << j ) ) r |= 1u << ( bits - 1 - j );
+    bitReverse_[i] = r;
+  }
+
+  // Partition p holds coefficients B(p+1) .. B(p+2)-1, zero padded to 2B.
+  spectra_.resize( (size_t) partitions_ * bins );
+  for ( unsigned int p=0; p<partitions_; p++ ) {
+    for ( unsigned int i=0; i<M; i++ ) {
+      size_t k = (size_t) B * ( p + 1 ) + i;
+      work_[i] = Complex( ( i < B && k < length ) ? b_[k] : 0.0, 0.0 );
+    }
+    this->fft( &work_[0], false );
+    for ( unsigned int i=0; i<bins; i++ ) spectra_[(size_t) p * bins + i] = work_[i];
+  }
+
+  this->clear();
+}
+
+void Convolver :: clear( void )
+{
+  head_.clear();
+  for ( size_t i=0; i<inputBlock_.size(); i++ ) inputBlock_[i] = 0.0;
+  for ( size_t i=0; i<tailOut_.size(); i++ ) tailOut_[i] = 0.0;
+  for ( size_t i=0; i<fdl_.size(); i++ ) fdl_[i] = Complex( 0.0, 0.0 );
+  blockIndex_ = 0;
+  fdlIndex_ = 0;
+  lastFrame_[0] = 0.0;
+}
+
+size_t Convolver :: heapBytes( void ) const
+{
+  size_t bytes = Filter::heapBytes() + head_.heapBytes();
+  bytes += ( inputBlock_.capacity() + tailOut_.capacity() ) * sizeof( StkFloat );
+  bytes += ( spectra_.capacity() + fdl_.capacity() + work_.capacity() + twiddles_.capacity() ) * sizeof( Complex );
+  return bytes + bitReverse_.capacity() * sizeof( unsigned int );
+}
+
+void Convolver :: processPartitions( void )
+{
+  // inputBlock_ holds the previous block followed by the block just
+  // completed.  Its spectrum enters the frequency-domain delay line,
+  // and the sum of each partition times its delayed input spectrum
+  // gives the tail output for the next B samples (overlap-save).
+  unsigned int B = partitionSize_, M = 2 * B, bins = B + 1;
+
+  for ( unsigned int i=0; i<M; i++ ) work_[i] = Complex( inputBlock_[i], 0.0 );
+  this->fft( &work_[0], false );
+
+  fdlIndex_ = ( fdlIndex_ == 0 ) ? partitions_ - 1 : fdlIndex_ - 1;
+  Complex *newest = &fdl_[(size_t) fdlIndex_ * bins];
+  for ( unsigned int i=0; i<bins; i++ ) newest[i] = work_[i];
+
+  for ( unsigned int i=0; i<bins; i++ ) work_[i] = Complex( 0.0, 0.0 );
+  unsigned int slot = fdlIndex_;
+  for ( unsigned int p=0; p<partitions_; p++ ) {
+    const Complex *x = &fdl_[(size_t) slot * bins];
+    const Complex *h = &spectra_[(size_t) p * bins];
+    for ( unsigned int i=0; i<bins; i++ ) work_[i] += x[i] * h[i];
+    if ( ++slot == partitions_ ) slot = 0;
+  }
+
+  // The input is real, so the upper half of the spectrum is the
+  // conjugate mirror of the lower half.
+  for ( unsigned int i=1; i<B; i++ ) work_[M - i] = std::conj( work_[i] );
+  this->fft( &work_[0], true );
+  for ( unsigned int i=0; i<B; i++ ) tailOut_[i] = work_[B + i].real();
+
+  for ( unsigned int i=0; i<B; i++ ) inputBlock_[i] = inputBlock_[B + i];
+}
+
+void Convolver :: fft( Complex *data, bool inverse ) const
+{
+  // Iterative radix-2 decimation in time.
+  unsigned int M = (unsigned int) bitReverse_.size();
+  for ( unsigned int i=0; i<M; i++ ) {
+    unsigned int j = bitReverse_[i];
+    if ( j > i ) std::swap( data[i], data[j] );
+  }
+
+  for ( unsigned int half=1; half<M; half <<= 1 ) {
+    unsigned int step = M / ( 2 * half );
+    for ( unsigned int start=0; start<M; start += 2 * half ) {
+      for ( unsigned int k=0; k<half; k++ ) {
+        Complex w = twiddles_[k * step];
+        if ( inverse ) w = std::conj( w );
+        Complex t = w * data[start + k + half];
+        data[start + k + half] = data[start + k] - t;
+        data[start + k] += t;
+      }
+    }
+  }
+
+  if ( inverse ) {
+    StkFloat scale = 1.0 / M;
+    for ( unsigned int i=0; i<M; i++ ) data[i] *= scale;
+  }
+}
+
+} // stk namespace
@@ -0,0 +1,250 @@
+#ifndef STK_CONVOLVER_H
+#define STK_CONVOLVER_H
+
+#include "Filter.h"
+#include "Fir.h"
+#include <complex>
+
+namespace stk {
+
+/***************************************************/
+/*! \class Convolver
+    \brief STK finite impulse response filter for long impulse responses.
+
+    This class computes the same output as Fir, y[n] = b[0]*x[n] +
+    ... + b[nb]*x[n-nb], with a cost that grows much more slowly with
+    the filter length.  It suits long impulse responses such as a
+    speaker or room colouration applied to an effect's wet path.
+
+    The filter runs in one of two forms:
+
+    - Direct: the whole filter runs in a Fir, which computes each
+      output as one contiguous dot product.
+
+    - Partitioned: the first \e B coefficients run in direct form,
+      and the rest are split into partitions of \e B coefficients
+      that are applied by uniformly-partitioned overlap-save FFT
+      convolution once every \e B samples.  The direct head covers
+      the FFT block delay, so there is no added latency.
+
+    In AUTOMATIC mode, setCoefficients() and setBlockSize() estimate
+    the cost per sample of each form for the filter length and pick
+    the cheaper one, along with the partition size \e B.  The
+    partition size is kept at or below the host block size, so the
+    FFT work lands evenly on each audio callback.
+
+    All memory is allocated by setCoefficients(), setBlockSize() and
+    setMode().  tick() does not allocate.
+*/
+/***************************************************/
+
+class Convolver : public Filter
+{
+public:
+
+  //! Form used to compute the convolution.
+  enum Mode {
+    AUTOMATIC,   /*!< Choose by cost estimate (default). */
+    DIRECT,      /*!< Direct form for the whole filter. */
+    PARTITIONED  /*!< Direct head plus FFT partitions. */
+  };
+
+  //! Default constructor creates a zero-order pass-through "filter".
+  Convolver( void );
+
+  //! Overloaded constructor which takes filter coefficients and the expected host block size.
+  /*!
+    An StkError can be thrown if the coefficient vector size is
+    zero.
+  */
+  Convolver( std::vector<StkFloat> &coefficients, unsigned int blockSize = RT_BUFFER_SIZE );
+
+  //! Class destructor.
+  ~Convolver( void );
+
+  //! Set filter coefficients.
+  /*!
+    An StkError can be thrown if the coefficient vector size is
+    zero.  The filter form is chosen again and the internal state is
+    always cleared.
+  */
+  void setCoefficients( std::vector<StkFloat> &coefficients );
+
+  //! Set the number of samples processed per host callback, used to choose the partition size.
+  void setBlockSize( unsigned int blockSize );
+
+  //! Force a filter form, or restore the AUTOMATIC choice.  The internal state is cleared.
+  void setMode( Mode mode );
+
+  //! Return true if the filter is currently using FFT partitions.
+  bool isPartitioned( void ) const { return partitions_ > 0; };
+
+  //! Return the partition size (and direct-form head length) in samples, or zero in direct form.
+  unsigned int getPartitionSize( void ) const { return partitions_ > 0 ? partitionSize_ : 0; };
+
+  //! Clears all internal states of the filter.
+  void clear( void );
+
+  //! Return the number of bytes the filter has allocated on the heap.
+  size_t heapBytes( void ) const;
+
+  //! Return the last computed output value.
+  StkFloat lastOut( void ) const { return lastFrame_[0]; };
+
+  //! Input one sample to the filter and return one output.
+  StkFloat tick( StkFloat input );
+
+  //! Take a channel of the StkFrames object as inputs to the filter and replace with corresponding outputs.
+  /*!
+    The StkFrames argument reference is returned.  The \c channel
+    argument must be less than the number of channels in the
+    StkFrames argument (the first channel is specified by 0).
+    However, range checking is only performed if _STK_DEBUG_ is
+    defined during compilation, in which case an out-of-range value
+    will trigger an StkError exception.
+  */
+  StkFrames& tick( StkFrames& frames, unsigned int channel = 0 );
+
+  //! Take a channel of the \c iFrames object as inputs to the filter and write outputs to the \c oFrames object.
+  /*!
+    The \c iFrames object reference is returned.  Each channel
+    argument must be less than the number of channels in the
+    corresponding StkFrames argument (the first channel is specified
+    by 0).  However, range checking is only performed if _STK_DEBUG_
+    is defined during compilation, in which case an out-of-range value
+    will trigger an StkError exception.
+  */
+  StkFrames& tick( StkFrames& iFrames, StkFrames &oFrames, unsigned int iChannel = 0, unsigned int oChannel = 0 );
+
+  //! Take a channel of the StkFrameView as inputs to the filter and replace with corresponding outputs.
+  /*!
+    The StkFrameView argument reference is returned.  Range checking
+    is only performed if _STK_DEBUG_ is defined during compilation.
+  */
+  StkFrameView& tick( StkFrameView& frames, unsigned int channel = 0 );
+
+  //! Take a channel of the \c iFrames view as inputs to the filter and write outputs to the \c oFrames view.
+  /*!
+    The \c iFrames view reference is returned.  Range checking is
+    only performed if _STK_DEBUG_ is defined during compilation.
+  */
+  StkFrameView& tick( StkFrameView& iFrames, StkFrameView &oFrames, unsigned int iChannel = 0, unsigned int oChannel = 0 );
+
+protected:
+
+  typedef std::complex<StkFloat> Complex;
+
+  void configure( void );
+  void processPartitions( void );
+  void fft( Complex *data, bool inverse ) const;
+
+  Mode mode_;
+  unsigned int blockSize_;
+
+  // direct form, for the whole filter or the first B coefficients
+  Fir head_;
+
+  // partitioned form
+  unsigned int partitionSize_;
+  unsigned int partitions_;
+  unsigned int blockIndex_;
+  unsigned int fdlIndex_;
+  std::vector<StkFloat> inputBlock_;
+  std::vector<StkFloat> tailOut_;
+  std::vector<Complex> spectra_;    // partition spectra, bins 0..B of each
+  std::vector<Complex> fdl_;        // frequency-domain delay line of input blocks
+  std::vector<Complex> work_;
+  std::vector<Complex> twiddles_;
+  std::vector<unsigned int> bitReverse_;
+};
+
+inline StkFloat Convolver :: tick( StkFloat input )
+{
+  StkFloat sample = gain_ * input;
+  lastFrame_[0] = head_.tick( sample );
+
+  if ( partitions_ > 0 ) {
+    lastFrame_[0] += tailOut_[blockIndex_];
+    inputBlock_[partitionSize_ + blockIndex_] = sample;
+    if ( ++blockIndex_ == partitionSize_ ) {
+      this->processPartitions();
+      blockIndex_ = 0;
+    }
+  }
+
+  return lastFrame_[0];
+}
+
+inline StkFrames& Convolver :: tick( StkFrames& frames, unsigned int channel )
+{
+#if defined(_STK_DEBUG_)
+  if ( channel >= frames.channels() ) {
+    oStream_ << "Convolver::tick(): channel and StkFrames arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  StkFloat *samples = &frames[channel];
+  unsigned int hop = frames.channels();
+  for ( unsigned int i=0; i<frames.frames(); i++, samples += hop )
+    *samples = tick( *samples );
+
+  return frames;
+}
+
+inline StkFrames& Convolver :: tick( StkFrames& iFrames, StkFrames& oFrames, unsigned int iChannel, unsigned int oChannel )
+{
+#if defined(_STK_DEBUG_)
+  if ( iChannel >= iFrames.channels() || oChannel >= oFrames.channels() ) {
+    oStream_ << "Convolver::tick(): channel and StkFrames arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  StkFloat *iSamples = &iFrames[iChannel];
+  StkFloat *oSamples = &oFrames[oChannel];
+  unsigned int iHop = iFrames.channels(), oHop = oFrames.channels();
+  for ( unsigned int i=0; i<iFrames.frames(); i++, iSamples += iHop, oSamples += oHop )
+    *oSamples = tick( *iSamples );
+
+  return iFrames;
+}
+
+inline StkFrameView& Convolver :: tick( StkFrameView& frames, unsigned int channel )
+{
+#if defined(_STK_DEBUG_)
+  if ( channel >= frames.channels() ) {
+    oStream_ << "Convolver::tick(): channel and StkFrameView arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  float *samples = frames.channel( channel );
+  unsigned int hop = frames.stride();
+  for ( unsigned int i=0; i<frames.frames(); i++, samples += hop )
+    *samples = (float) tick( *samples );
+
+  return frames;
+}
+
+inline StkFrameView& Convolver :: tick( StkFrameView& iFrames, StkFrameView& oFrames, unsigned int iChannel, unsigned int oChannel )
+{
+#if defined(_STK_DEBUG_)
+  if ( iChannel >= iFrames.channels() || oChannel >= oFrames.channels() ) {
+    oStream_ << "Convolver::tick(): channel and StkFrameView arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  float *iSamples = iFrames.channel( iChannel );
+  float *oSamples = oFrames.channel( oChannel );
+  unsigned int iHop = iFrames.stride(), oHop = oFrames.stride();
+  for ( unsigned int i=0; i<iFrames.frames(); i++, iSamples += iHop, oSamples += oHop )
+    *oSamples = (float) tick( *iSamples );
+
+  return iFrames;
+}
+
+} // stk namespace
+
+#endif
@@ -35,8 +35,7 @@ DelayA :: DelayA( StkFloat delay, unsigned long maxDelay )
   }
 
   // Writing before reading allows delays from 0 to length-1. 
-  if ( maxDelay + 1 > inputs_.size() )
-    inputs_.resize( maxDelay + 1, 1, 0.0 );
+  buffer_.resize( maxDelay + 1 );
 
   inPoint_ = 0;
   this->setDelay( delay );
@@ -50,21 +49,34 @@ DelayA :: ~DelayA()
 
 void DelayA :: clear()
 {
-  for ( unsigned int i=0; i<inputs_.size(); i++ )
-    inputs_[i] = 0.0;
+  buffer_.clear();
   lastFrame_[0] = 0.0;
   apInput_ = 0.0;
 }
 
-void DelayA :: setMaximumDelay( unsigned long delay )
+void DelayA :: setMaximumDelay( unsigned long delay, bool shrink )
 {
-  if ( delay < inputs_.size() ) return;
-  inputs_.resize(delay + 1, 1, 0.0);
+  if ( delay < buffer_.size() ) {
+    // Nothing to do unless the rounded-up size would actually shrink.
+    if ( !shrink || delay + 1 > buffer_.size() / 2 ) return;
+  }
+
+  buffer_.resize( delay + 1 );
+  inPoint_ &= buffer_.mask();
+  if ( delay_ > (StkFloat) delay ) delay_ = delay;
+  this->setDelay( delay_ );
+}
+
+void DelayA :: setStorageFormat( Stk::StkFormat format )
+{
+  buffer_.setFormat( format );
+  lastFrame_[0] = 0.0;
+  apInput_ = 0.0;
 }
 
 void DelayA :: setDelay( StkFloat delay )
 {
-  unsigned long length = inputs_.size();
+  unsigned long length = buffer_.size();
   if ( delay + 1 > length ) { // The value is too big.
     oStream_ << "DelayA::setDelay: argument (" << delay << ") greater than maximum!";
     handleError( StkError::WARNING ); return;
@@ -98,20 +110,13 @@ void DelayA :: setDelay( StkFloat delay )
 
 StkFloat DelayA :: tapOut( unsigned long tapDelay )
 {
-  long tap = inPoint_ - tapDelay - 1;
-  while ( tap < 0 ) // Check for wraparound.
-    tap += inputs_.size();
-
-  return inputs_[tap];
+  // Wraparound is handled by the power-of-two mask.
+  return buffer_[ ( inPoint_ - tapDelay - 1 ) & buffer_.mask() ];
 }
 
 void DelayA :: tapIn( StkFloat value, unsigned long tapDelay )
 {
-  long tap = inPoint_ - tapDelay - 1;
-  while ( tap < 0 ) // Check for wraparound.
-    tap += inputs_.size();
-
-  inputs_[tap] = value;
+  buffer_.set( ( inPoint_ - tapDelay - 1 ) & buffer_.mask(), value );
 }
 
 } // stk namespace
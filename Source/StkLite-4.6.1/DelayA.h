@@ -2,6 +2,7 @@
 #define STK_DELAYA_H
 
 #include "Filter.h"
+#include "RingBuffer.h"
 
 namespace stk {
 
@@ -21,6 +22,24 @@ namespace stk {
     minimum delay possible in this implementation is limited to a
     value of 0.5.
 
+    The delay history is held in a power-of-two RingBuffer, so the
+    read and write pointers wrap with a mask rather than a compare and
+    branch.  The maximum delay reported by getMaximumDelay() is
+    therefore the requested maximum rounded up to a power of two, less
+    one.  The block tick() functions check the history storage format
+    once per call rather than on every sample, and the modulated one
+    sets a new delay for each sample, as a chorus or flanger needs.
+    It works out the read points and coefficients for a run of samples
+    first, then runs the allpass recursion over them.
+
+    The history does not use the RingBuffer's mirrored storage.  Each
+    allpass output feeds the next one, so reading the history as one
+    contiguous span would not turn the recursion into a SIMD loop, and
+    with a modulated delay the read point is recomputed every sample
+    and can repeat or skip a sample, so the reads are not one span
+    anyway.  Mirroring would only double the history's memory and
+    writes.
+
     by Perry R. Cook and Gary P. Scavone, 1995--2019.
 */
 /***************************************************/
@@ -44,7 +63,7 @@ public:
   void clear( void );
 
   //! Get the maximum delay-line length.
-  unsigned long getMaximumDelay( void ) { return inputs_.size() - 1; };
+  unsigned long getMaximumDelay( void ) { return buffer_.size() - 1; };
   
   //! Set the maximum delay-line length.
   /*!
@@ -52,9 +71,25 @@ public:
     of the delay line.  If it is used between calls to the tick()
     function, without a call to clear(), a signal discontinuity will
     likely occur.  If the current maximum length is greater than the
-    new length, no memory allocation change is made.
+    new length, no memory allocation change is made unless \e shrink
+    is true, in which case the buffer is reallocated to fit and the
+    current delay is limited to the new maximum.
   */
-  void setMaximumDelay( unsigned long delay );
+  void setMaximumDelay( unsigned long delay, bool shrink = false );
+
+  //! Set the sample format used to store the delay-line history.
+  /*!
+    Stk::STK_FLOAT64 (the default), Stk::STK_FLOAT32 and
+    Stk::STK_SINT16 are supported.  Smaller formats reduce the memory
+    footprint at the cost of precision.  The delay line is cleared.
+  */
+  void setStorageFormat( Stk::StkFormat format );
+
+  //! Return the sample format used to store the delay-line history.
+  Stk::StkFormat getStorageFormat( void ) const { return buffer_.getFormat(); };
+
+  //! Return the number of bytes the delay line has allocated on the heap.
+  size_t heapBytes( void ) const { return Filter::heapBytes() + buffer_.heapBytes(); };
 
   //! Set the delay-line length
   /*!
@@ -110,8 +145,53 @@ public:
   */
   StkFrames& tick( StkFrames& iFrames, StkFrames &oFrames, unsigned int iChannel = 0, unsigned int oChannel = 0 );
 
+  //! Take a channel of the StkFrameView as inputs to the filter and replace with corresponding outputs.
+  /*!
+    The StkFrameView argument reference is returned.  This works as
+    the StkFrames version, but on float data in place, for example
+    a channel of a host audio buffer.  The \c channel argument must
+    be less than the number of channels in the view.  However, range
+    checking is only performed if _STK_DEBUG_ is defined during
+    compilation, in which case an out-of-range value will trigger an
+    StkError exception.
+  */
+  StkFrameView& tick( StkFrameView& frames, unsigned int channel = 0 );
+
+  //! Take a channel of the \c iFrames view as inputs to the filter and write outputs to the \c oFrames view.
+  /*!
+    The \c iFrames view reference is returned.  Each channel argument
+    must be less than the number of channels in the corresponding
+    view.  However, range checking is only performed if _STK_DEBUG_
+    is defined during compilation, in which case an out-of-range value
+    will trigger an StkError exception.
+  */
+  StkFrameView& tick( StkFrameView& iFrames, StkFrameView &oFrames, unsigned int iChannel = 0, unsigned int oChannel = 0 );
+
+  //! Input \e nFrames samples, with the delay set to \e delays[i] before sample \e i, and write the outputs.
+  /*!
+    Equivalent to calling setDelay( delays[i] ) and tick( input[i] )
+    for each sample, writing \e output[i].  \e Sample is float or
+    double, and \e input and \e output may be the same array.
+  */
+  template <typename Sample>
+  void tick( const Sample *input, Sample *output, const StkFloat *delays, unsigned int nFrames );
+
 protected:  
 
+  template <typename T> StkFloat nextOut( void );
+  template <typename T> StkFloat tickSample( StkFloat input );
+  template <typename T, typename Sample>
+  void tickSamples( const Sample *input, unsigned int iHop, Sample *output, unsigned int oHop, unsigned int nFrames );
+  template <typename Sample>
+  void tickStrided( const Sample *input, unsigned int iHop, Sample *output, unsigned int oHop, unsigned int nFrames );
+  void locate( StkFloat delay, unsigned long in, unsigned long &point, StkFloat &alpha ) const;
+  template <typename T, typename Sample>
+  void tickModulated( const Sample *input, Sample *output, const StkFloat *delays, unsigned int nFrames );
+
+  // Samples per pass of the modulated tick().
+  static const unsigned int MODULATED_CHUNK = 64;
+
+  RingBuffer buffer_;
   unsigned long inPoint_;
   unsigned long outPoint_;
   StkFloat delay_;
@@ -122,37 +202,66 @@ protected:
   bool doNextOut_;
 };
 
+template <typename T>
 inline StkFloat DelayA :: nextOut( void )
 {
   if ( doNextOut_ ) {
     // Do allpass interpolation delay.
     nextOutput_ = -coeff_ * lastFrame_[0];
-    nextOutput_ += apInput_ + ( coeff_ * inputs_[outPoint_] );
+    nextOutput_ += apInput_ + ( coeff_ * buffer_.get<T>( outPoint_ ) );
     doNextOut_ = false;
   }
 
   return nextOutput_;
 }
 
-inline StkFloat DelayA :: tick( StkFloat input )
+inline StkFloat DelayA :: nextOut( void )
 {
-  inputs_[inPoint_++] = input * gain_;
+  if ( buffer_.getFormat() == Stk::STK_FLOAT32 ) return this->nextOut<FLOAT32>();
+  if ( buffer_.getFormat() == Stk::STK_SINT16 ) return this->nextOut<SINT16>();
+  return this->nextOut<StkFloat>();
+}
+
+template <typename T>
+inline StkFloat DelayA :: tickSample( StkFloat input )
+{
+  buffer_.put<T>( inPoint_, input * gain_ );
 
   // Increment input pointer modulo length.
-  if ( inPoint_ == inputs_.size() )
-    inPoint_ = 0;
+  inPoint_ = ( inPoint_ + 1 ) & buffer_.mask();
 
-  lastFrame_[0] = nextOut();
+  lastFrame_[0] = this->nextOut<T>();
   doNextOut_ = true;
 
   // Save the allpass input and increment modulo length.
-  apInput_ = inputs_[outPoint_++];
-  if ( outPoint_ == inputs_.size() )
-    outPoint_ = 0;
+  apInput_ = buffer_.get<T>( outPoint_ );
+  outPoint_ = ( outPoint_ + 1 ) & buffer_.mask();
 
   return lastFrame_[0];
 }
 
+inline StkFloat DelayA :: tick( StkFloat input )
+{
+  if ( buffer_.getFormat() == Stk::STK_FLOAT32 ) return this->tickSample<FLOAT32>( input );
+  if ( buffer_.getFormat() == Stk::STK_SINT16 ) return this->tickSample<SINT16>( input );
+  return this->tickSample<StkFloat>( input );
+}
+
+template <typename T, typename Sample>
+inline void DelayA :: tickSamples( const Sample *input, unsigned int iHop, Sample *output, unsigned int oHop, unsigned int nFrames )
+{
+  for ( unsigned int i=0; i<nFrames; i++, input += iHop, output += oHop )
+    *output = (Sample) this->tickSample<T>( *input );
+}
+
+template <typename Sample>
+inline void DelayA :: tickStrided( const Sample *input, unsigned int iHop, Sample *output, unsigned int oHop, unsigned int nFrames )
+{
+  if ( buffer_.getFormat() == Stk::STK_FLOAT32 ) this->tickSamples<FLOAT32>( input, iHop, output, oHop, nFrames );
+  else if ( buffer_.getFormat() == Stk::STK_SINT16 ) this->tickSamples<SINT16>( input, iHop, output, oHop, nFrames );
+  else this->tickSamples<StkFloat>( input, iHop, output, oHop, nFrames );
+}
+
 inline StkFrames& DelayA :: tick( StkFrames& frames, unsigned int channel )
 {
 #if defined(_STK_DEBUG_)
@@ -164,15 +273,7 @@ inline StkFrames& DelayA :: tick( StkFrames& frames, unsigned int channel )
 
   StkFloat *samples = &frames[channel];
   unsigned int hop = frames.channels();
-  for ( unsigned int i=0; i<frames.frames(); i++, samples += hop ) {
-    inputs_[inPoint_++] = *samples * gain_;
-    if ( inPoint_ == inputs_.size() ) inPoint_ = 0;
-    *samples = nextOut();
-    lastFrame_[0] = *samples;
-    doNextOut_ = true;
-    apInput_ = inputs_[outPoint_++];
-    if ( outPoint_ == inputs_.size() ) outPoint_ = 0;
-  }
+  this->tickStrided( samples, hop, samples, hop, frames.frames() );
 
   return frames;
 }
@@ -186,22 +287,136 @@ inline StkFrames& DelayA :: tick( StkFrames& iFrames, StkFrames& oFrames, unsign
   }
 #endif
 
-  StkFloat *iSamples = &iFrames[iChannel];
-  StkFloat *oSamples = &oFrames[oChannel];
-  unsigned int iHop = iFrames.channels(), oHop = oFrames.channels();
-  for ( unsigned int i=0; i<iFrames.frames(); i++, iSamples += iHop, oSamples += oHop ) {
-    inputs_[inPoint_++] = *iSamples * gain_;
-    if ( inPoint_ == inputs_.size() ) inPoint_ = 0;
-    *oSamples = nextOut();
-    lastFrame_[0] = *oSamples;
-    doNextOut_ = true;
-    apInput_ = inputs_[outPoint_++];
-    if ( outPoint_ == inputs_.size() ) outPoint_ = 0;
+  this->tickStrided( &iFrames[iChannel], iFrames.channels(), &oFrames[oChannel], oFrames.channels(), iFrames.frames() );
+
+  return iFrames;
+}
+
+inline StkFrameView& DelayA :: tick( StkFrameView& frames, unsigned int channel )
+{
+#if defined(_STK_DEBUG_)
+  if ( channel >= frames.channels() ) {
+    oStream_ << "DelayA::tick(): channel and StkFrameView arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  float *samples = frames.channel( channel );
+  unsigned int hop = frames.stride();
+  this->tickStrided( samples, hop, samples, hop, frames.frames() );
+
+  return frames;
+}
+
+inline StkFrameView& DelayA :: tick( StkFrameView& iFrames, StkFrameView& oFrames, unsigned int iChannel, unsigned int oChannel )
+{
+#if defined(_STK_DEBUG_)
+  if ( iChannel >= iFrames.channels() || oChannel >= oFrames.channels() ) {
+    oStream_ << "DelayA::tick(): channel and StkFrameView arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
   }
+#endif
+
+  this->tickStrided( iFrames.channel( iChannel ), iFrames.stride(), oFrames.channel( oChannel ), oFrames.stride(), iFrames.frames() );
 
   return iFrames;
 }
 
+inline void DelayA :: locate( StkFloat delay, unsigned long in, unsigned long &point, StkFloat &alpha ) const
+{
+  // setDelay() for a delay in range, with its loop reduced to the one
+  // wrap such a delay can need.
+  unsigned long length = buffer_.size();
+  StkFloat outPointer = in - delay + 1.0;
+  outPointer += outPointer < 0 ? length : 0;
+  point = (unsigned long) outPointer;
+  point = point == length ? 0 : point;
+  alpha = 1.0 + point - outPointer;
+  if ( alpha < 0.5 ) {
+    point = ( point + 1 ) & buffer_.mask();
+    alpha += (StkFloat) 1.0;
+  }
+}
+
+template <typename T, typename Sample>
+inline void DelayA :: tickModulated( const Sample *input, Sample *output, const StkFloat *delays, unsigned int nFrames )
+{
+  // An output computed ahead by nextOut() used the old delay, so that
+  // sample goes through setDelay() and tickSample() as before.
+  if ( nFrames > 0 && !doNextOut_ ) {
+    this->setDelay( delays[0] );
+    output[0] = (Sample) this->tickSample<T>( input[0] );
+    input++; output++; delays++; nFrames--;
+  }
+
+  const unsigned long length = buffer_.size();
+  const unsigned long mask = buffer_.mask();
+  unsigned long points[MODULATED_CHUNK];
+  StkFloat coeffs[MODULATED_CHUNK];
+
+  while ( nFrames > 0 ) {
+    unsigned int n = nFrames;
+    if ( n > MODULATED_CHUNK ) n = MODULATED_CHUNK;
+
+    // First pass: the read point and allpass coefficient setDelay()
+    // would give each sample, with the same arithmetic.  Nothing
+    // carries from one sample to the next, so the division and the
+    // wrap no longer sit in front of each step of the recursion.
+    bool inRange = true;
+    for ( unsigned int i=0; i<n; i++ ) {
+      inRange &= ( delays[i] + 1 <= length ) & ( delays[i] >= 0.5 );
+      StkFloat alpha;
+      this->locate( delays[i], ( inPoint_ + i ) & mask, points[i], alpha );
+      coeffs[i] = (1.0 - alpha) / (1.0 + alpha);
+    }
+
+    if ( !inRange ) {
+      // setDelay() warns about, and for a long one ignores, a delay
+      // out of range, so let it handle this chunk.
+      for ( unsigned int i=0; i<n; i++ ) {
+        this->setDelay( delays[i] );
+        output[i] = (Sample) this->tickSample<T>( input[i] );
+      }
+    }
+    else {
+      // Second pass: the allpass recursion, which has to go one sample
+      // at a time.  A read can be of the sample just written, so each
+      // write comes before its read.
+      StkFloat last = lastFrame_[0];
+      StkFloat apInput = apInput_;
+      for ( unsigned int i=0; i<n; i++ ) {
+        buffer_.put<T>( inPoint_, input[i] * gain_ );
+        inPoint_ = ( inPoint_ + 1 ) & mask;
+        StkFloat sample = buffer_.get<T>( points[i] );
+        StkFloat next = -coeffs[i] * last;
+        next += apInput + ( coeffs[i] * sample );
+        last = next;
+        apInput = sample;
+        output[i] = (Sample) last;
+      }
+      lastFrame_[0] = last;
+      apInput_ = apInput;
+
+      // Leave the state as setDelay( delays[n-1] ) and tick() would.
+      unsigned long point;
+      this->locate( delays[n-1], ( inPoint_ - 1 ) & mask, point, alpha_ );
+      delay_ = delays[n-1];
+      coeff_ = coeffs[n-1];
+      outPoint_ = ( point + 1 ) & mask;
+    }
+
+    input += n; output += n; delays += n; nFrames -= n;
+  }
+}
+
+template <typename Sample>
+inline void DelayA :: tick( const Sample *input, Sample *output, const StkFloat *delays, unsigned int nFrames )
+{
+  if ( buffer_.getFormat() == Stk::STK_FLOAT32 ) this->tickModulated<FLOAT32>( input, output, delays, nFrames );
+  else if ( buffer_.getFormat() == Stk::STK_SINT16 ) this->tickModulated<SINT16>( input, output, delays, nFrames );
+  else this->tickModulated<StkFloat>( input, output, delays, nFrames );
+}
+
 } // stk namespace
 
 #endif
@@ -52,6 +52,9 @@ public:
    */
   StkFloat phaseDelay( StkFloat frequency );
 
+  //! Return the number of bytes the filter has allocated on the heap.
+  virtual size_t heapBytes( void ) const;
+
   //! Return an StkFrames reference to the last output sample frame.
   const StkFrames& lastFrame( void ) const { return lastFrame_; };
 
@@ -90,14 +93,20 @@ inline void Filter :: clear( void )
     lastFrame_[i] = 0.0;  
 }
 
+inline size_t Filter :: heapBytes( void ) const
+{
+  size_t samples = inputs_.capacity() + outputs_.capacity() + lastFrame_.capacity();
+  return ( samples + b_.capacity() + a_.capacity() ) * sizeof( StkFloat );
+}
+
 inline StkFloat Filter :: phaseDelay( StkFloat frequency )
 {
-  if ( frequency <= 0.0 || frequency > 0.5 * Stk::sampleRate() ) {
+  if ( frequency <= 0.0 || frequency > 0.5 * contextSampleRate() ) {
     oStream_ << "Filter::phaseDelay: argument (" << frequency << ") is out of range!";
     handleError( StkError::WARNING ); return 0.0;
   }
 
-  StkFloat omegaT = 2 * PI * frequency / Stk::sampleRate();
+  StkFloat omegaT = 2 * PI * frequency / contextSampleRate();
   StkFloat real = 0.0, imag = 0.0;
   for ( unsigned int i=0; i<b_.size(); i++ ) {
     real += b_[i] * std::cos( i * omegaT );
@@ -16,6 +16,9 @@
     This structure results in one extra multiply per computed sample,
     but allows easy control of the overall filter gain.
 
+    The input history is kept in a mirrored circular buffer, so each
+    output is one contiguous dot product with no history shift.
+
     by Perry R. Cook and Gary P. Scavone, 1995--2019.
 */
 /***************************************************/
@@ -26,14 +29,16 @@
 namespace stk {
 
 Fir :: Fir()
+  : history_( 0, true )
 {
   // The default constructor should setup for pass-through.
   b_.push_back( 1.0 );
 
-  inputs_.resize( 1, 1, 0.0 );
+  this->setHistory();
 }
 
 Fir :: Fir( std::vector<StkFloat> &coefficients )
+  : history_( 0, true )
 {
   // Check the arguments.
   if ( coefficients.size() == 0 ) {
@@ -44,7 +49,7 @@ Fir :: Fir( std::vector<StkFloat> &coefficients )
   gain_ = 1.0;
   b_ = coefficients;
 
-  inputs_.resize( b_.size(), 1, 0.0 );
+  this->setHistory();
   this->clear();
 }
 
@@ -62,13 +67,36 @@ void Fir :: setCoefficients( std::vector<StkFloat> &coefficients, bool clearStat
 
   if ( b_.size() != coefficients.size() ) {
     b_ = coefficients;
-    inputs_.resize( b_.size(), 1, 0.0 );
+    this->setHistory();
   }
   else {
     for ( unsigned int i=0; i<b_.size(); i++ ) b_[i] = coefficients[i];
+    for ( unsigned int i=0; i<b_.size(); i++ ) reversed_[i] = b_[b_.size() - 1 - i];
   }
 
   if ( clearState ) this->clear();
 }
 
+void Fir :: clear( void )
+{
+  history_.clear();
+  Filter::clear();
+}
+
+size_t Fir :: heapBytes( void ) const
+{
+  return Filter::heapBytes() + history_.heapBytes() + reversed_.capacity() * sizeof( StkFloat );
+}
+
+void Fir :: setHistory( void )
+{
+  // Coefficients are stored time-reversed so they line up with the
+  // oldest-first history span.  The history holds a full block chunk
+  // beyond the filter order for the block tick functions.  A resize
+  // clears the history.
+  reversed_.resize( b_.size() );
+  for ( unsigned int i=0; i<b_.size(); i++ ) reversed_[i] = b_[b_.size() - 1 - i];
+  history_.resize( (unsigned long) ( b_.size() - 1 + BLOCK_CHUNK ) );
+}
+
 } // stk namespace
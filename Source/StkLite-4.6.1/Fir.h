@@ -2,6 +2,7 @@
 #define STK_FIR_H
 
 #include "Filter.h"
+#include "RingBuffer.h"
 
 namespace stk {
 
@@ -23,6 +24,13 @@ namespace stk {
     This structure results in one extra multiply per computed sample,
     but allows easy control of the overall filter gain.
 
+    The input history is kept in a mirrored circular buffer, so each
+    output is one contiguous dot product against time-reversed
+    coefficients, with no per-sample history shift.  The block tick()
+    functions write a chunk of input and then compute several
+    outputs per pass over the coefficients, which suits the
+    oversampling and halfband stages of an effect's wet path.
+
     by Perry R. Cook and Gary P. Scavone, 1995--2019.
 */
 /***************************************************/
@@ -51,6 +59,12 @@ public:
   */
   void setCoefficients( std::vector<StkFloat> &coefficients, bool clearState = false );
 
+  //! Clears all internal states of the filter.
+  void clear( void );
+
+  //! Return the number of bytes the filter has allocated on the heap.
+  size_t heapBytes( void ) const;
+
   //! Return the last computed output value.
   StkFloat lastOut( void ) const { return lastFrame_[0]; };
 
@@ -79,21 +93,101 @@ public:
   */
   StkFrames& tick( StkFrames& iFrames, StkFrames &oFrames, unsigned int iChannel = 0, unsigned int oChannel = 0 );
 
+  //! Take a channel of the StkFrameView as inputs to the filter and replace with corresponding outputs.
+  /*!
+    The StkFrameView argument reference is returned.  This works as
+    the StkFrames version, but on float data in place, for example
+    a channel of a host audio buffer.  The \c channel argument must
+    be less than the number of channels in the view.  However, range
+    checking is only performed if _STK_DEBUG_ is defined during
+    compilation, in which case an out-of-range value will trigger an
+    StkError exception.
+  */
+  StkFrameView& tick( StkFrameView& frames, unsigned int channel = 0 );
+
+  //! Take a channel of the \c iFrames view as inputs to the filter and write outputs to the \c oFrames view.
+  /*!
+    The \c iFrames view reference is returned.  Each channel argument
+    must be less than the number of channels in the corresponding
+    view.  However, range checking is only performed if _STK_DEBUG_
+    is defined during compilation, in which case an out-of-range value
+    will trigger an StkError exception.
+  */
+  StkFrameView& tick( StkFrameView& iFrames, StkFrameView &oFrames, unsigned int iChannel = 0, unsigned int oChannel = 0 );
+
 protected:
 
+  // Number of input samples a block tick writes before computing their outputs.
+  static const unsigned int BLOCK_CHUNK = 64;
+
+  void setHistory( void );
+  StkFloat dot( const StkFloat *history ) const;
+  template <typename In, typename Out>
+  void tickBlock( const In *input, unsigned int inHop, Out *output, unsigned int outHop, unsigned int nFrames );
+
+  std::vector<StkFloat> reversed_;
+  RingBuffer history_;
 };
 
-inline StkFloat Fir :: tick( StkFloat input )
+inline StkFloat Fir :: dot( const StkFloat *history ) const
 {
-  lastFrame_[0] = 0.0;
-  inputs_[0] = gain_ * input;
+  // Four partial sums break the add dependency chain for vectorization.
+  const StkFloat *h = &reversed_[0];
+  size_t n = reversed_.size(), i = 0;
+  StkFloat s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+  for ( ; i + 4 <= n; i += 4 ) {
+    s0 += h[i] * history[i];
+    s1 += h[i+1] * history[i+1];
+    s2 += h[i+2] * history[i+2];
+    s3 += h[i+3] * history[i+3];
+  }
+  for ( ; i < n; i++ ) s0 += h[i] * history[i];
 
-  for ( unsigned int i=(unsigned int)(b_.size())-1; i>0; i-- ) {
-    lastFrame_[0] += b_[i] * inputs_[i];
-    inputs_[i] = inputs_[i-1];
+  return ( s0 + s1 ) + ( s2 + s3 );
+}
+
+template <typename In, typename Out>
+inline void Fir :: tickBlock( const In *input, unsigned int inHop, Out *output, unsigned int outHop, unsigned int nFrames )
+{
+  unsigned long order = (unsigned long) reversed_.size() - 1;
+  const StkFloat *h = &reversed_[0];
+
+  while ( nFrames > 0 ) {
+    unsigned int count = nFrames < BLOCK_CHUNK ? nFrames : BLOCK_CHUNK;
+    for ( unsigned int j=0; j<count; j++, input += inHop )
+      history_.write( gain_ * *input );
+
+    // Output j of the chunk is the dot product starting at x[j].  Four
+    // outputs share each coefficient load.
+    const StkFloat *x = history_.span( 0, order + count );
+    unsigned int j = 0;
+    for ( ; j + 4 <= count; j += 4, x += 4 ) {
+      StkFloat s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+      for ( unsigned long i=0; i<=order; i++ ) {
+        s0 += h[i] * x[i];
+        s1 += h[i] * x[i+1];
+        s2 += h[i] * x[i+2];
+        s3 += h[i] * x[i+3];
+      }
+      output[0] = (Out) s0; output += outHop;
+      output[0] = (Out) s1; output += outHop;
+      output[0] = (Out) s2; output += outHop;
+      output[0] = (Out) s3; output += outHop;
+      lastFrame_[0] = s3;
+    }
+    for ( ; j<count; j++, x++, output += outHop ) {
+      lastFrame_[0] = dot( x );
+      *output = (Out) lastFrame_[0];
+    }
+
+    nFrames -= count;
   }
-  lastFrame_[0] += b_[0] * inputs_[0];
+}
 
+inline StkFloat Fir :: tick( StkFloat input )
+{
+  history_.write( gain_ * input );
+  lastFrame_[0] = dot( history_.span( 0, (unsigned long) reversed_.size() ) );
   return lastFrame_[0];
 }
 
@@ -106,20 +200,9 @@ inline StkFrames& Fir :: tick( StkFrames& frames, unsigned int channel )
   }
 #endif
 
+  if ( frames.frames() == 0 ) return frames;
   StkFloat *samples = &frames[channel];
-  unsigned int i, hop = frames.channels();
-  for ( unsigned int j=0; j<frames.frames(); j++, samples += hop ) {
-    inputs_[0] = gain_ * *samples;
-    *samples = 0.0;
-
-    for ( i=(unsigned int)b_.size()-1; i>0; i-- ) {
-      *samples += b_[i] * inputs_[i];
-      inputs_[i] = inputs_[i-1];
-    }
-    *samples += b_[0] * inputs_[0];
-  }
-
-  lastFrame_[0] = *(samples-hop);
+  tickBlock( samples, frames.channels(), samples, frames.channels(), frames.frames() );
   return frames;
 }
 
@@ -132,21 +215,35 @@ inline StkFrames& Fir :: tick( StkFrames& iFrames, StkFrames& oFrames, unsigned
   }
 #endif
 
-  StkFloat *iSamples = &iFrames[iChannel];
-  StkFloat *oSamples = &oFrames[oChannel];
-  unsigned int i, iHop = iFrames.channels(), oHop = oFrames.channels();
-  for ( unsigned int j=0; j<iFrames.frames(); j++, iSamples += iHop, oSamples += oHop ) {
-    inputs_[0] = gain_ * *iSamples;
-    *oSamples = 0.0;
+  if ( iFrames.frames() == 0 ) return iFrames;
+  tickBlock( &iFrames[iChannel], iFrames.channels(), &oFrames[oChannel], oFrames.channels(), iFrames.frames() );
+  return iFrames;
+}
 
-    for ( i=(unsigned int)b_.size()-1; i>0; i-- ) {
-      *oSamples += b_[i] * inputs_[i];
-      inputs_[i] = inputs_[i-1];
-    }
-    *oSamples += b_[0] * inputs_[0];
+inline StkFrameView& Fir :: tick( StkFrameView& frames, unsigned int channel )
+{
+#if defined(_STK_DEBUG_)
+  if ( channel >= frames.channels() ) {
+    oStream_ << "Fir::tick(): channel and StkFrameView arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
   }
+#endif
+
+  float *samples = frames.channel( channel );
+  tickBlock( samples, frames.stride(), samples, frames.stride(), frames.frames() );
+  return frames;
+}
+
+inline StkFrameView& Fir :: tick( StkFrameView& iFrames, StkFrameView& oFrames, unsigned int iChannel, unsigned int oChannel )
+{
+#if defined(_STK_DEBUG_)
+  if ( iChannel >= iFrames.channels() || oChannel >= oFrames.channels() ) {
+    oStream_ << "Fir::tick(): channel and StkFrameView arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
 
-  lastFrame_[0] = *(oSamples-oHop);
+  tickBlock( iFrames.channel( iChannel ), iFrames.stride(), oFrames.channel( oChannel ), oFrames.stride(), iFrames.frames() );
   return iFrames;
 }
 
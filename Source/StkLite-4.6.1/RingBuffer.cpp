@@ -0,0 +1,144 @@
+/***************************************************/
+/*! \class RingBuffer
+    \brief STK power-of-two circular sample buffer.
+
+    This class holds delay-line history in a cache-aligned circular
+    buffer whose capacity is a power of two, optionally mirrored so
+    that reads never wrap.
+*/
+/***************************************************/
+
+#include "RingBuffer.h"
+#include <stdlib.h>
+#include <stdint.h>
+
+namespace stk {
+
+RingBuffer :: RingBuffer( unsigned long length, bool mirrored, Stk::StkFormat format )
+  : data_( 0 ), data32_( 0 ), data16_( 0 ), storage_( 0 ), block_( 0 ), size_( 0 ), mask_( 0 ),
+    writeIndex_( 0 ), mirrored_( mirrored ), format_( Stk::STK_FLOAT64 )
+{
+  this->setFormat( format );
+  this->resize( length );
+}
+
+RingBuffer :: ~RingBuffer()
+{
+  this->release();
+}
+
+RingBuffer :: RingBuffer( const RingBuffer& other )
+  : data_( 0 ), data32_( 0 ), data16_( 0 ), storage_( 0 ), block_( 0 ), size_( 0 ), mask_( 0 ),
+    writeIndex_( 0 ), mirrored_( other.mirrored_ ), format_( other.format_ )
+{
+  *this = other;
+}
+
+RingBuffer& RingBuffer :: operator= ( const RingBuffer& other )
+{
+  if ( this == &other ) return *this;
+  if ( other.size_ == 0 ) {
+    this->release();
+    mirrored_ = other.mirrored_;
+    format_ = other.format_;
+    writeIndex_ = 0;
+    return *this;
+  }
+
+  this->allocate( other.size_, other.mirrored_, other.format_ );
+  memcpy( storage_, other.storage_, this->bytes() );
+  writeIndex_ = other.writeIndex_;
+  return *this;
+}
+
+void RingBuffer :: resize( unsigned long length )
+{
+  // Round up to the next power of two, keeping at least one sample.
+  unsigned long capacity = 1;
+  while ( capacity < length ) capacity <<= 1;
+
+  this->allocate( capacity, mirrored_, format_ );
+  this->clear();
+}
+
+void RingBuffer :: setMirrored( bool mirrored )
+{
+  this->allocate( size_ > 0 ? size_ : 1, mirrored, format_ );
+  this->clear();
+}
+
+void RingBuffer :: setFormat( Stk::StkFormat format )
+{
+  if ( format != Stk::STK_FLOAT64 && format != Stk::STK_FLOAT32 && format != Stk::STK_SINT16 ) {
+    Stk::handleError( "RingBuffer::setFormat: unsupported storage format!", StkError::FUNCTION_ARGUMENT );
+    return;
+  }
+
+  if ( size_ == 0 ) {
+    format_ = format;
+    return;
+  }
+
+  this->allocate( size_, mirrored_, format );
+  this->clear();
+}
+
+void RingBuffer :: clear( void )
+{
+  if ( size_ > 0 )
+    memset( storage_, 0, this->bytes() );
+  writeIndex_ = 0;
+}
+
+size_t RingBuffer :: sampleBytes( void ) const
+{
+  if ( format_ == Stk::STK_FLOAT32 ) return sizeof( FLOAT32 );
+  if ( format_ == Stk::STK_SINT16 ) return sizeof( SINT16 );
+  return sizeof( StkFloat );
+}
+
+size_t RingBuffer :: bytes( void ) const
+{
+  return ( mirrored_ ? 2 * size_ : size_ ) * this->sampleBytes();
+}
+
+void RingBuffer :: allocate( unsigned long capacity, bool mirrored, Stk::StkFormat format )
+{
+  if ( capacity == size_ && mirrored == mirrored_ && format == format_ && block_ ) return;
+
+  this->release();
+  size_ = capacity;
+  mask_ = capacity - 1;
+  mirrored_ = mirrored;
+  format_ = format;
+
+  // Over-allocate and round the data pointer up to the alignment boundary.
+  block_ = malloc( this->bytes() + ALIGNMENT - 1 );
+  if ( block_ == NULL ) {
+    size_ = 0;
+    mask_ = 0;
+    Stk::handleError( "RingBuffer::allocate: memory allocation error!", StkError::MEMORY_ALLOCATION );
+    return;
+  }
+
+  uintptr_t address = ( (uintptr_t) block_ + ALIGNMENT - 1 ) & ~( (uintptr_t) ALIGNMENT - 1 );
+  storage_ = (void *) address;
+  if ( format_ == Stk::STK_FLOAT32 ) data32_ = (FLOAT32 *) address;
+  else if ( format_ == Stk::STK_SINT16 ) data16_ = (SINT16 *) address;
+  else data_ = (StkFloat *) address;
+  writeIndex_ = 0;
+}
+
+void RingBuffer :: release( void )
+{
+  if ( block_ ) free( block_ );
+  block_ = 0;
+  storage_ = 0;
+  data_ = 0;
+  data32_ = 0;
+  data16_ = 0;
+  size_ = 0;
+  mask_ = 0;
+}
+
+} // stk namespace
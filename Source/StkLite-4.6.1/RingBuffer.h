@@ -0,0 +1,221 @@
+#ifndef STK_RINGBUFFER_H
+#define STK_RINGBUFFER_H
+
+#include "Stk.h"
+
+namespace stk {
+
+/***************************************************/
+/*! \class RingBuffer
+    \brief STK power-of-two circular sample buffer.
+
+    This class holds delay-line history in a circular buffer whose
+    capacity is always rounded up to a power of two, so index
+    wraparound is a single bitwise AND instead of a compare and
+    branch.  Storage is aligned to a 64-byte cache line.
+
+    If the buffer is \e mirrored, every write is duplicated one
+    capacity past its position.  Any run of up to capacity() samples
+    can then be read through span() as one contiguous array, which
+    lets block readers use plain (vectorizable) loads without ever
+    splitting a read at the end of the buffer.  Mirroring doubles the
+    memory used and costs one extra store per write.
+
+    History is stored as StkFloat by default.  setFormat() can
+    select Stk::STK_FLOAT32 or Stk::STK_SINT16 storage instead, which
+    halves or quarters the memory (and cache) footprint at the cost of
+    a conversion on every access and reduced precision.  span() and
+    data() are only meaningful for Stk::STK_FLOAT64 storage.
+    operator[] and set() check the format on every access; per-sample
+    loops should instead pick it once and use get() and put(), which
+    take the storage type as a template argument.
+
+    The buffer can be used either through its own write position
+    (write(), read(), span()) or as raw storage indexed by the owner
+    (operator[], set(), mask()), which is how DelayA uses it.
+*/
+/***************************************************/
+
+class RingBuffer
+{
+public:
+
+  //! Alignment of the sample storage in bytes.
+  static const size_t ALIGNMENT = 64;
+
+  //! Create a buffer holding at least \e length samples.
+  RingBuffer( unsigned long length = 0, bool mirrored = false, Stk::StkFormat format = Stk::STK_FLOAT64 );
+
+  //! Class destructor.
+  ~RingBuffer();
+
+  //! Copy constructor.
+  RingBuffer( const RingBuffer& other );
+
+  //! Assignment operator.
+  RingBuffer& operator= ( const RingBuffer& other );
+
+  //! Reallocate to hold at least \e length samples and clear the contents.
+  /*!
+    The capacity is rounded up to the next power of two.  No memory
+    is allocated if the rounded capacity and mirroring are unchanged.
+   */
+  void resize( unsigned long length );
+
+  //! Enable or disable mirrored storage.  The contents are cleared.
+  void setMirrored( bool mirrored );
+
+  //! Return true if writes are duplicated past the end of the buffer.
+  bool isMirrored( void ) const { return mirrored_; };
+
+  //! Set the sample storage format.  The contents are cleared.
+  /*!
+    Supported formats are Stk::STK_FLOAT64 (the default),
+    Stk::STK_FLOAT32 and Stk::STK_SINT16.  Any other value triggers
+    an StkError::FUNCTION_ARGUMENT and leaves the format unchanged.
+   */
+  void setFormat( Stk::StkFormat format );
+
+  //! Return the sample storage format.
+  Stk::StkFormat getFormat( void ) const { return format_; };
+
+  //! Zero the contents and reset the write position.
+  void clear( void );
+
+  //! Return the (power-of-two) number of samples held.
+  unsigned long size( void ) const { return size_; };
+
+  //! Return the index mask, size() - 1.
+  unsigned long mask( void ) const { return mask_; };
+
+  //! Return the number of bytes used for sample storage.
+  size_t bytes( void ) const;
+
+  //! Return the number of bytes allocated on the heap, including alignment padding.
+  size_t heapBytes( void ) const { return block_ ? this->bytes() + ALIGNMENT - 1 : 0; };
+
+  //! Return the sample at \e index, which must be less than size().
+  StkFloat operator[] ( unsigned long index ) const;
+
+  //! Store \e value at \e index, which must be less than size().
+  void set( unsigned long index, StkFloat value );
+
+  //! Return the sample at \e index from storage of type \e T, which must match getFormat().
+  /*!
+    \e T is StkFloat for Stk::STK_FLOAT64, FLOAT32 for
+    Stk::STK_FLOAT32 or SINT16 for Stk::STK_SINT16.  The index must
+    be less than size().
+   */
+  template <typename T> StkFloat get( unsigned long index ) const;
+
+  //! Store \e value at \e index in storage of type \e T, which must match getFormat().
+  template <typename T> void put( unsigned long index, StkFloat value );
+
+  //! Append \e value at the write position and advance it.
+  void write( StkFloat value );
+
+  //! Return the index the next write() will store to.
+  unsigned long writeIndex( void ) const { return writeIndex_; };
+
+  //! Return the sample written \e delay writes ago (0 is the most recent).
+  StkFloat read( unsigned long delay ) const { return (*this)[ ( writeIndex_ - 1 - delay ) & mask_ ]; };
+
+  //! Return a contiguous view of \e length samples ending \e delay writes ago.
+  /*!
+    The returned pointer addresses the oldest sample of the run, so
+    element \c length - 1 is the sample read( \e delay ) would
+    return.  Only valid on a mirrored Stk::STK_FLOAT64 buffer, and \e delay + \e length
+    must not exceed size().
+   */
+  const StkFloat *span( unsigned long delay, unsigned long length ) const;
+
+  //! Return the underlying Stk::STK_FLOAT64 storage.
+  const StkFloat *data( void ) const { return data_; };
+
+protected:
+
+  void allocate( unsigned long capacity, bool mirrored, Stk::StkFormat format );
+  void release( void );
+  size_t sampleBytes( void ) const;
+
+  StkFloat *data_;
+  FLOAT32 *data32_;
+  SINT16 *data16_;
+  void *storage_;
+  void *block_;
+  unsigned long size_;
+  unsigned long mask_;
+  unsigned long writeIndex_;
+  bool mirrored_;
+  Stk::StkFormat format_;
+};
+
+template <typename T>
+inline StkFloat RingBuffer :: get( unsigned long index ) const
+{
+  return static_cast<const T *>( storage_ )[index];
+}
+
+template <>
+inline StkFloat RingBuffer :: get<SINT16>( unsigned long index ) const
+{
+  return static_cast<const SINT16 *>( storage_ )[index] * ( 1.0 / 32768.0 );
+}
+
+template <typename T>
+inline void RingBuffer :: put( unsigned long index, StkFloat value )
+{
+  T *samples = static_cast<T *>( storage_ );
+  samples[index] = (T) value;
+  if ( mirrored_ ) samples[index + size_] = (T) value;
+}
+
+template <>
+inline void RingBuffer :: put<SINT16>( unsigned long index, StkFloat value )
+{
+  // Saturate rather than wrap on out-of-range input.
+  StkFloat scaled = value * 32768.0;
+  if ( scaled > 32767.0 ) scaled = 32767.0;
+  else if ( scaled < -32768.0 ) scaled = -32768.0;
+  SINT16 sample = (SINT16) ( scaled < 0.0 ? scaled - 0.5 : scaled + 0.5 );
+  SINT16 *samples = static_cast<SINT16 *>( storage_ );
+  samples[index] = sample;
+  if ( mirrored_ ) samples[index + size_] = sample;
+}
+
+inline StkFloat RingBuffer :: operator[] ( unsigned long index ) const
+{
+  if ( format_ == Stk::STK_FLOAT32 ) return this->get<FLOAT32>( index );
+  if ( format_ == Stk::STK_SINT16 ) return this->get<SINT16>( index );
+  return this->get<StkFloat>( index );
+}
+
+inline void RingBuffer :: set( unsigned long index, StkFloat value )
+{
+  if ( format_ == Stk::STK_FLOAT32 ) this->put<FLOAT32>( index, value );
+  else if ( format_ == Stk::STK_SINT16 ) this->put<SINT16>( index, value );
+  else this->put<StkFloat>( index, value );
+}
+
+inline void RingBuffer :: write( StkFloat value )
+{
+  set( writeIndex_, value );
+  writeIndex_ = ( writeIndex_ + 1 ) & mask_;
+}
+
+inline const StkFloat *RingBuffer :: span( unsigned long delay, unsigned long length ) const
+{
+#if defined(_STK_DEBUG_)
+  if ( !mirrored_ || !data_ || delay + length > size_ ) {
+    std::ostringstream error;
+    error << "RingBuffer::span: invalid delay (" << delay << ") or length (" << length << ") value!";
+    Stk::handleError( error.str(), StkError::MEMORY_ACCESS );
+  }
+#endif
+
+  return data_ + ( ( writeIndex_ - delay - length ) & mask_ );
+}
+
+} // stk namespace
+
+#endif
@@ -0,0 +1,88 @@
+/***************************************************/
+/*! \class SVF
+    \brief STK topology-preserving state-variable filter class.
+
+    This class implements a second-order state-variable filter using
+    the topology-preserving (trapezoidal) transform.  Its cutoff can
+    be changed on every sample without recomputing a full set of
+    biquad coefficients.
+*/
+/***************************************************/
+
+#include "SVF.h"
+#include <cmath>
+
+namespace stk {
+
+SVF :: SVF() : Filter()
+{
+  mode_ = LOWPASS;
+  k_ = std::sqrt( 2.0 );
+  this->clear();
+  this->setSampleRate( Stk::sampleRate() );
+  this->setFrequency( 1000.0 );
+}
+
+SVF :: ~SVF()
+{
+  if ( context_ ) context_->removeSampleRateAlert( this );
+}
+
+void SVF :: setContext( StkContext *context )
+{
+  if ( context_ ) context_->removeSampleRateAlert( this );
+  Stk::setContext( context );
+  if ( !context ) return;
+
+  context->addSampleRateAlert( this );
+  this->sampleRateChanged( context->sampleRate(), sampleRate_ );
+}
+
+void SVF :: sampleRateChanged( StkFloat newRate, StkFloat /*oldRate*/ )
+{
+  this->setSampleRate( newRate );
+  this->setFrequency( frequency_ );
+}
+
+void SVF :: clear( void )
+{
+  for ( unsigned int c=0; c<2; c++ ) {
+    ic1eq_[c] = 0.0;
+    ic2eq_[c] = 0.0;
+  }
+  lastFrame_[0] = 0.0;
+}
+
+void SVF :: setSampleRate( StkFloat rate )
+{
+  if ( rate <= 0.0 ) {
+    oStream_ << "SVF::setSampleRate: argument (" << rate << ") must be positive!";
+    handleError( StkError::WARNING ); return;
+  }
+
+  sampleRate_ = rate;
+  piOverRate_ = PI / rate;
+}
+
+void SVF :: setQ( StkFloat q )
+{
+  if ( q <= 0.0 ) {
+    oStream_ << "SVF::setQ: argument (" << q << ") must be positive!";
+    handleError( StkError::WARNING ); return;
+  }
+
+  k_ = 1.0 / q;
+  this->setG( g_ );
+}
+
+void SVF :: setFrequency( StkFloat frequency )
+{
+  // Limit the cutoff to just below Nyquist, where the tangent blows up.
+  if ( frequency < 0.0 ) frequency = 0.0;
+  else if ( frequency > 0.49 * sampleRate_ ) frequency = 0.49 * sampleRate_;
+
+  frequency_ = frequency;
+  this->setG( std::tan( piOverRate_ * frequency ) );
+}
+
+} // stk namespace
@@ -0,0 +1,286 @@
+#ifndef STK_SVF_H
+#define STK_SVF_H
+
+#include "Filter.h"
+
+namespace stk {
+
+/***************************************************/
+/*! \class SVF
+    \brief STK topology-preserving state-variable filter class.
+
+    This class implements a second-order state-variable filter using
+    the topology-preserving (trapezoidal) transform.  Its lowpass,
+    bandpass and highpass responses match the bilinear-transformed
+    analog prototypes (the same responses BiQuad produces with
+    prewarped coefficients), but its state is expressed as two
+    integrator memories rather than past inputs and outputs.  The
+    cutoff can therefore be changed on every sample without the
+    transients a direct-form biquad produces, and a cutoff change
+    costs only a tangent and one division.
+
+    The filter keeps integrator states for a second channel, so one
+    object can filter a stereo pair with shared coefficients.
+    tickChannels() runs both channels of a block side by side, which
+    lets the compiler hold the pair in one SIMD register and, when the
+    cutoff is modulated, works out the coefficients once per sample
+    rather than once per channel.  The single-channel tick() functions
+    use the first channel's state.
+
+    The sample rate defaults to Stk::sampleRate() and can be set
+    per instance with setSampleRate().  When attached to an
+    StkContext with setContext(), the filter follows the context
+    sample rate instead, keeping its cutoff in Hz.
+*/
+/***************************************************/
+
+class SVF : public Filter
+{
+public:
+
+  //! Filter response returned by tick().
+  enum Mode {
+    LOWPASS,
+    BANDPASS,
+    HIGHPASS
+  };
+
+  //! Default constructor creates a 1 kHz lowpass filter with Q = 0.7071.
+  SVF();
+
+  //! Class destructor.
+  ~SVF();
+
+  //! Attach the filter to \e context and follow its sample rate.
+  void setContext( StkContext *context );
+
+  //! Clears the integrator states of the filter.
+  void clear( void );
+
+  //! Set the sample rate used to map frequencies in Hz to coefficients.
+  void setSampleRate( StkFloat rate );
+
+  //! Select which response is returned by tick().
+  void setMode( Mode mode ) { mode_ = mode; };
+
+  //! Set the filter Q (resonance).  The value must be positive.
+  void setQ( StkFloat q );
+
+  //! Set the cutoff \e frequency (in Hz) using an exact prewarped tangent.
+  void setFrequency( StkFloat frequency );
+
+  //! Set the cutoff \e frequency (in Hz) using a rational tangent approximation.
+  /*!
+    Intended to be called every sample for sweeps and modulation.  The
+    integrator gain is within 0.1% of the exact tangent up to 0.3
+    times the sample rate and within 0.85% up to 0.4 times (where the
+    resulting cutoff is about 0.2% low); the error grows quickly
+    above that.  The frequency is limited to stay below Nyquist.
+   */
+  void modulateFrequency( StkFloat frequency );
+
+  //! Return the current cutoff frequency in Hz.
+  StkFloat getFrequency( void ) const { return frequency_; };
+
+  //! Return the last computed output value.
+  StkFloat lastOut( void ) const { return lastFrame_[0]; };
+
+  //! Input one sample to the filter and return one output.
+  StkFloat tick( StkFloat input );
+
+  //! Take a channel of the StkFrames object as inputs to the filter and replace with corresponding outputs.
+  /*!
+    The StkFrames argument reference is returned.  The \c channel
+    argument must be less than the number of channels in the
+    StkFrames argument (the first channel is specified by 0).
+    However, range checking is only performed if _STK_DEBUG_ is
+    defined during compilation, in which case an out-of-range value
+    will trigger an StkError exception.
+  */
+  StkFrames& tick( StkFrames& frames, unsigned int channel = 0 );
+
+  //! Take a channel of the \c iFrames object as inputs to the filter and write outputs to the \c oFrames object.
+  /*!
+    The \c iFrames object reference is returned.  Each channel
+    argument must be less than the number of channels in the
+    corresponding StkFrames argument (the first channel is specified
+    by 0).  However, range checking is only performed if _STK_DEBUG_
+    is defined during compilation, in which case an out-of-range value
+    will trigger an StkError exception.
+  */
+  StkFrames& tick( StkFrames& iFrames, StkFrames &oFrames, unsigned int iChannel = 0, unsigned int oChannel = 0 );
+
+  //! Filter \e nFrames samples of two channels in place, each with its own state.
+  /*!
+    Both channels use this filter's coefficients; \e first uses the
+    same state as tick().  \e Sample is float or double.
+  */
+  template <typename Sample>
+  void tickChannels( Sample *first, Sample *second, unsigned int nFrames );
+
+  //! Filter two channels as above, with modulateFrequency( \e frequencies[i] ) before sample \e i.
+  template <typename Sample>
+  void tickChannels( Sample *first, Sample *second, const StkFloat *frequencies, unsigned int nFrames );
+
+protected:
+
+  void sampleRateChanged( StkFloat newRate, StkFloat oldRate );
+  void setG( StkFloat g );
+  void coefficients( StkFloat g, StkFloat &a1, StkFloat &a2, StkFloat &a3 ) const;
+  StkFloat approximateG( StkFloat frequency ) const;
+  template <bool modulated, typename Sample>
+  void tickPair( Sample *first, Sample *second, const StkFloat *frequencies, unsigned int nFrames );
+
+  Mode mode_;
+  StkFloat sampleRate_;
+  StkFloat piOverRate_;
+  StkFloat frequency_;
+  StkFloat k_;     // damping, 1 / Q
+  StkFloat g_;     // integrator gain, tan( PI * frequency / rate )
+  StkFloat a1_;
+  StkFloat a2_;
+  StkFloat a3_;
+  StkFloat ic1eq_[2]; // integrator states of the first and second channel
+  StkFloat ic2eq_[2];
+};
+
+inline void SVF :: coefficients( StkFloat g, StkFloat &a1, StkFloat &a2, StkFloat &a3 ) const
+{
+  a1 = 1.0 / ( 1.0 + g * ( g + k_ ) );
+  a2 = g * a1;
+  a3 = g * a2;
+}
+
+inline void SVF :: setG( StkFloat g )
+{
+  g_ = g;
+  this->coefficients( g_, a1_, a2_, a3_ );
+}
+
+inline StkFloat SVF :: approximateG( StkFloat frequency ) const
+{
+  // Keep clear of the tangent approximation's pole at sqrt(2.5).
+  StkFloat x = piOverRate_ * frequency;
+  if ( x < 0.0 ) x = 0.0;
+  else if ( x > 1.4 ) x = 1.4;
+
+  StkFloat x2 = x * x;
+  return x * ( 15.0 - x2 ) / ( 15.0 - 6.0 * x2 );
+}
+
+inline void SVF :: modulateFrequency( StkFloat frequency )
+{
+  frequency_ = frequency;
+  setG( this->approximateG( frequency ) );
+}
+
+inline StkFloat SVF :: tick( StkFloat input )
+{
+  StkFloat v0 = gain_ * input;
+  StkFloat v3 = v0 - ic2eq_[0];
+  StkFloat v1 = a1_ * ic1eq_[0] + a2_ * v3;
+  StkFloat v2 = ic2eq_[0] + a2_ * ic1eq_[0] + a3_ * v3;
+  ic1eq_[0] = 2.0 * v1 - ic1eq_[0];
+  ic2eq_[0] = 2.0 * v2 - ic2eq_[0];
+
+  if ( mode_ == LOWPASS ) lastFrame_[0] = v2;
+  else if ( mode_ == BANDPASS ) lastFrame_[0] = v1;
+  else lastFrame_[0] = v0 - k_ * v1 - v2;
+
+  return lastFrame_[0];
+}
+
+inline StkFrames& SVF :: tick( StkFrames& frames, unsigned int channel )
+{
+#if defined(_STK_DEBUG_)
+  if ( channel >= frames.channels() ) {
+    oStream_ << "SVF::tick(): channel and StkFrames arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  StkFloat *samples = &frames[channel];
+  unsigned int hop = frames.channels();
+  for ( unsigned int i=0; i<frames.frames(); i++, samples += hop )
+    *samples = tick( *samples );
+
+  return frames;
+}
+
+inline StkFrames& SVF :: tick( StkFrames& iFrames, StkFrames& oFrames, unsigned int iChannel, unsigned int oChannel )
+{
+#if defined(_STK_DEBUG_)
+  if ( iChannel >= iFrames.channels() || oChannel >= oFrames.channels() ) {
+    oStream_ << "SVF::tick(): channel and StkFrames arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  StkFloat *iSamples = &iFrames[iChannel];
+  StkFloat *oSamples = &oFrames[oChannel];
+  unsigned int iHop = iFrames.channels(), oHop = oFrames.channels();
+  for ( unsigned int i=0; i<iFrames.frames(); i++, iSamples += iHop, oSamples += oHop )
+    *oSamples = tick( *iSamples );
+
+  return iFrames;
+}
+
+template <bool modulated, typename Sample>
+inline void SVF :: tickPair( Sample *first, Sample *second, const StkFloat *frequencies, unsigned int nFrames )
+{
+  // Locals rather than members, so stores to the samples can't force
+  // reloads, and the channel loop innermost over arrays of two, so the
+  // compiler can run it in one SIMD register.
+  const StkFloat gain = gain_, k = k_;
+  const Mode mode = mode_;
+  StkFloat g = g_, a1 = a1_, a2 = a2_, a3 = a3_;
+  StkFloat ic1eq[2] = { ic1eq_[0], ic1eq_[1] };
+  StkFloat ic2eq[2] = { ic2eq_[0], ic2eq_[1] };
+  StkFloat out[2] = { lastFrame_[0], 0.0 };
+
+  for ( unsigned int i=0; i<nFrames; i++ ) {
+    if ( modulated ) {
+      g = this->approximateG( frequencies[i] );
+      this->coefficients( g, a1, a2, a3 );
+    }
+
+    StkFloat in[2] = { gain * first[i], gain * second[i] };
+    for ( unsigned int c=0; c<2; c++ ) {
+      StkFloat v0 = in[c];
+      StkFloat v3 = v0 - ic2eq[c];
+      StkFloat v1 = a1 * ic1eq[c] + a2 * v3;
+      StkFloat v2 = ic2eq[c] + a2 * ic1eq[c] + a3 * v3;
+      ic1eq[c] = 2.0 * v1 - ic1eq[c];
+      ic2eq[c] = 2.0 * v2 - ic2eq[c];
+      out[c] = mode == LOWPASS ? v2 : mode == BANDPASS ? v1 : v0 - k * v1 - v2;
+    }
+    first[i] = (Sample) out[0];
+    second[i] = (Sample) out[1];
+  }
+
+  if ( modulated && nFrames > 0 ) {
+    frequency_ = frequencies[nFrames-1];
+    g_ = g; a1_ = a1; a2_ = a2; a3_ = a3;
+  }
+  for ( unsigned int c=0; c<2; c++ ) {
+    ic1eq_[c] = ic1eq[c];
+    ic2eq_[c] = ic2eq[c];
+  }
+  lastFrame_[0] = out[0];
+}
+
+template <typename Sample>
+inline void SVF :: tickChannels( Sample *first, Sample *second, unsigned int nFrames )
+{
+  this->tickPair<false>( first, second, 0, nFrames );
+}
+
+template <typename Sample>
+inline void SVF :: tickChannels( Sample *first, Sample *second, const StkFloat *frequencies, unsigned int nFrames )
+{
+  this->tickPair<true>( first, second, frequencies, nFrames );
+}
+
+} // stk namespace
+
+#endif
@@ -0,0 +1,425 @@
+/***************************************************/
+/*! \class SosCascade
+    \brief STK cascade of second-order filter sections.
+
+    This class computes an Iir transfer function as a cascade of
+    transposed direct form II second-order sections, with one state
+    per channel.  Iir-style coefficients are factored into sections
+    by finding the roots of the numerator and denominator.
+*/
+/***************************************************/
+
+#include "SosCascade.h"
+#include <complex>
+#include <algorithm>
+#include <limits>
+
+namespace stk {
+
+typedef std::complex<StkFloat> Complex;
+
+// A polynomial root, or a root at infinity (a leading zero b
+// coefficient, i.e. a pure delay).
+struct Root {
+  Complex value;
+  bool infinite;
+};
+
+// One or two roots forming a first or second order factor.
+struct RootGroup {
+  Root roots[2];
+  unsigned int count;
+};
+
+SosCascade :: SosCascade( unsigned int channels )
+  : sections_( 0 ), channels_( 0 )
+{
+  // The default constructor should setup for pass-through.
+  b_.push_back( 1.0 );
+  a_.push_back( 1.0 );
+
+  std::vector<StkFloat> sections( 6, 0.0 );
+  sections[0] = 1.0;
+  sections[3] = 1.0;
+  this->setSections( sections );
+  this->setChannels( channels );
+}
+
+SosCascade :: SosCascade( std::vector<StkFloat> &bCoefficients, std::vector<StkFloat> &aCoefficients, unsigned int channels )
+  : sections_( 0 ), channels_( 0 )
+{
+  gain_ = 1.0;
+  this->setCoefficients( bCoefficients, aCoefficients );
+  this->setChannels( channels );
+}
+
+SosCascade :: ~SosCascade()
+{
+}
+
+void SosCascade :: setCoefficients( std::vector<StkFloat> &bCoefficients, std::vector<StkFloat> &aCoefficients, bool clearState )
+{
+  // Check the arguments.
+  if ( bCoefficients.size() == 0 || aCoefficients.size() == 0 ) {
+    oStream_ << "SosCascade::setCoefficients: a and b coefficient vectors must both have size > 0!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+
+  if ( aCoefficients[0] == 0.0 ) {
+    oStream_ << "SosCascade::setCoefficients: a[0] coefficient cannot == 0!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+
+  std::vector<StkFloat> sections;
+  this->factor( bCoefficients, aCoefficients, sections );
+  this->setSections( sections, clearState );
+
+  // Keep the polynomial form for Filter::phaseDelay().
+  b_ = bCoefficients;
+  a_ = aCoefficients;
+  if ( a_[0] != 1.0 ) {
+    for ( unsigned int i=0; i<b_.size(); i++ ) b_[i] /= a_[0];
+    for ( unsigned int i=1; i<a_.size(); i++ ) a_[i] /= a_[0];
+    a_[0] = 1.0;
+  }
+}
+
+void SosCascade :: setSections( std::vector<StkFloat> &sections, bool clearState )
+{
+  // Check the argument.
+  if ( sections.size() == 0 || sections.size() % 6 != 0 ) {
+    oStream_ << "SosCascade::setSections: section vector size must be a non-zero multiple of 6!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+
+  unsigned int count = (unsigned int) ( sections.size() / 6 );
+  for ( unsigned int s=0; s<count; s++ ) {
+    if ( sections[6*s + 3] == 0.0 ) {
+      oStream_ << "SosCascade::setSections: a0 coefficient of section " << s << " cannot == 0!";
+      handleError( StkError::FUNCTION_ARGUMENT );
+    }
+  }
+
+  coefficients_.resize( 5 * count );
+  for ( unsigned int s=0; s<count; s++ ) {
+    const StkFloat *in = &sections[6*s];
+    StkFloat *out = &coefficients_[5*s];
+    out[0] = in[0] / in[3];
+    out[1] = in[1] / in[3];
+    out[2] = in[2] / in[3];
+    out[3] = in[4] / in[3];
+    out[4] = in[5] / in[3];
+  }
+
+  if ( count != sections_ ) {
+    sections_ = count;
+    z1_.resize( (size_t) sections_ * channels_ );
+    z2_.resize( (size_t) sections_ * channels_ );
+    clearState = true;
+  }
+
+  if ( clearState ) this->clear();
+}
+
+std::vector<StkFloat> SosCascade :: getSections( void ) const
+{
+  std::vector<StkFloat> sections( 6 * sections_ );
+  for ( unsigned int s=0; s<sections_; s++ ) {
+    const StkFloat *in = &coefficients_[5*s];
+    StkFloat *out = &sections[6*s];
+    out[0] = in[0];
+    out[1] = in[1];
+    out[2] = in[2];
+    out[3] = 1.0;
+    out[4] = in[3];
+    out[5] = in[4];
+  }
+
+  return sections;
+}
+
+void SosCascade :: setChannels( unsigned int channels )
+{
+  if ( channels == 0 ) {
+    oStream_ << "SosCascade::setChannels: argument must be greater than zero!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+
+  channels_ = channels;
+  z1_.resize( (size_t) sections_ * channels_ );
+  z2_.resize( (size_t) sections_ * channels_ );
+  lanes_.resize( channels_ );
+  lastFrame_.resize( 1, channels_, 0.0 );
+  this->clear();
+}
+
+void SosCascade :: clear( void )
+{
+  std::fill( z1_.begin(), z1_.end(), 0.0 );
+  std::fill( z2_.begin(), z2_.end(), 0.0 );
+  Filter::clear();
+}
+
+size_t SosCascade :: heapBytes( void ) const
+{
+  size_t samples = coefficients_.capacity() + z1_.capacity() + z2_.capacity() + lanes_.capacity();
+  return Filter::heapBytes() + samples * sizeof( StkFloat );
+}
+
+// Divide the descending-power polynomial p by (z - root) while root
+// is a root of it, returning the number of times it divided.
+static unsigned int deflate( std::vector<StkFloat> &p, StkFloat root )
+{
+  unsigned int count = 0;
+  while ( p.size() > 1 ) {
+    StkFloat scale = 0.0;
+    for ( size_t i=0; i<p.size(); i++ ) scale += std::fabs( p[i] );
+
+    std::vector<StkFloat> q( p.size() - 1 );
+    StkFloat r = p[0];
+    for ( size_t i=1; i<p.size(); i++ ) {
+      q[i-1] = r;
+      r = p[i] + r * root;
+    }
+    if ( std::fabs( r ) > 1e-10 * scale ) break;
+
+    p = q;
+    count++;
+  }
+
+  return count;
+}
+
+// Find the roots of the descending-power polynomial p with the
+// Aberth-Ehrlich iteration.  Returns false if it did not converge.
+static bool findRoots( const std::vector<StkFloat> &p, std::vector<Complex> &roots )
+{
+  size_t n = p.size() - 1;
+  roots.resize( n );
+  if ( n == 0 ) return true;
+
+  // Start on a circle of the roots' geometric mean radius, rotated
+  // off the real axis so conjugate pairs can separate.
+  StkFloat radius = std::pow( std::fabs( p[n] / p[0] ), 1.0 / n );
+  if ( radius == 0.0 ) radius = 1.0;
+  for ( size_t i=0; i<n; i++ )
+    roots[i] = std::polar( radius, TWO_PI * i / n + 0.4 );
+
+  for ( int iteration=0; iteration<500; iteration++ ) {
+    StkFloat change = 0.0;
+    for ( size_t i=0; i<n; i++ ) {
+      Complex value = p[0], slope = 0.0;
+      for ( size_t k=1; k<=n; k++ ) {
+        slope = slope * roots[i] + value;
+        value = value * roots[i] + p[k];
+      }
+      if ( value == Complex( 0.0, 0.0 ) ) continue;
+
+      Complex ratio = value / slope;
+      Complex repulsion = 0.0;
+      for ( size_t j=0; j<n; j++ )
+        if ( j != i ) repulsion += 1.0 / ( roots[i] - roots[j] );
+      Complex delta = ratio / ( 1.0 - ratio * repulsion );
+      roots[i] -= delta;
+      change = std::max( change, std::abs( delta ) / std::max( (StkFloat) 1.0, std::abs( roots[i] ) ) );
+    }
+    if ( change < 1e-14 ) return true;
+  }
+
+  // Clustered roots can't settle any closer than the rounding error of
+  // evaluating the polynomial, so accept them once they are within it.
+  for ( size_t i=0; i<n; i++ ) {
+    Complex value = p[0];
+    StkFloat bound = std::fabs( p[0] ), magnitude = std::abs( roots[i] );
+    for ( size_t k=1; k<=n; k++ ) {
+      value = value * roots[i] + p[k];
+      bound = bound * magnitude + std::fabs( p[k] );
+    }
+    if ( std::abs( value ) > 4.0 * n * std::numeric_limits<StkFloat>::epsilon() * bound ) return false;
+  }
+
+  return true;
+}
+
+static bool lessReal( const Root &a, const Root &b )
+{
+  if ( a.infinite != b.infinite ) return b.infinite;
+  return a.value.real() < b.value.real();
+}
+
+// Group roots into conjugate pairs, then pairs of real roots sorted by
+// value, leaving a single real root last if the count is odd.
+static void groupRoots( const std::vector<Root> &roots, std::vector<RootGroup> &groups )
+{
+  std::vector<Root> reals;
+  for ( size_t i=0; i<roots.size(); i++ ) {
+    const Root &r = roots[i];
+    StkFloat tolerance = 1e-8 * std::max( (StkFloat) 1.0, std::abs( r.value ) );
+    if ( r.infinite || std::fabs( r.value.imag() ) <= tolerance ) {
+      Root real = r;
+      real.value = Complex( r.value.real(), 0.0 );
+      reals.push_back( real );
+    }
+    else if ( r.value.imag() > 0.0 ) {
+      RootGroup g;
+      g.roots[0] = r;
+      g.roots[1].value = std::conj( r.value );
+      g.roots[1].infinite = false;
+      g.count = 2;
+      groups.push_back( g );
+    }
+  }
+
+  std::sort( reals.begin(), reals.end(), lessReal );
+  for ( size_t i=0; i<reals.size(); i += 2 ) {
+    RootGroup g;
+    g.roots[0] = reals[i];
+    g.count = 1;
+    if ( i + 1 < reals.size() ) {
+      g.roots[1] = reals[i+1];
+      g.count = 2;
+    }
+    groups.push_back( g );
+  }
+}
+
+// Expand a root group into 1 + c1 z^-1 + c2 z^-2.
+static void expand( const RootGroup &g, StkFloat *c )
+{
+  Complex p[3] = { 1.0, 0.0, 0.0 };
+  for ( unsigned int i=0; i<g.count; i++ ) {
+    // Multiply by (1 - r z^-1), or by z^-1 for a root at infinity.
+    const Root &r = g.roots[i];
+    if ( r.infinite ) {
+      p[2] = p[1];
+      p[1] = p[0];
+      p[0] = 0.0;
+    }
+    else {
+      p[2] -= r.value * p[1];
+      p[1] -= r.value * p[0];
+    }
+  }
+  for ( int i=0; i<3; i++ ) c[i] = p[i].real();
+}
+
+static StkFloat maxRadius( const RootGroup &g )
+{
+  StkFloat radius = 0.0;
+  for ( unsigned int i=0; i<g.count; i++ ) radius = std::max( radius, std::abs( g.roots[i].value ) );
+  return radius;
+}
+
+static bool lessRadius( const RootGroup &a, const RootGroup &b )
+{
+  return maxRadius( a ) < maxRadius( b );
+}
+
+// Collect the roots of a coefficient vector, in powers of z^-1.
+// Leading zero coefficients become roots at infinity.  If \e unitRoots
+// is true, roots at z = +1 and -1 (common multiple zeros of bilinear
+// designs) are divided out exactly before the iterative search.  That
+// is only safe for zeros: a stable, resonant denominator can come
+// within the tolerance of z = 1 without having a root there.
+static bool polynomialRoots( const std::vector<StkFloat> &coefficients, std::vector<Root> &roots, StkFloat &leading, bool unitRoots )
+{
+  size_t first = 0, last = coefficients.size();
+  while ( first < last && coefficients[first] == 0.0 ) first++;
+  while ( last > first && coefficients[last-1] == 0.0 ) last--;
+
+  roots.clear();
+  leading = 0.0;
+  if ( first == last ) return true;
+  leading = coefficients[first];
+
+  Root r;
+  r.infinite = true;
+  r.value = 0.0;
+  for ( size_t i=0; i<first; i++ ) roots.push_back( r );
+  r.infinite = false;
+
+  // b[first] z^n + ... + b[last-1], with n = last - first - 1.  Trailing
+  // zero coefficients are roots at z = 0, which contribute a factor of 1.
+  std::vector<StkFloat> p( coefficients.begin() + first, coefficients.begin() + last );
+  for ( StkFloat unit = -1.0; unitRoots && unit <= 1.0; unit += 2.0 ) {
+    unsigned int count = deflate( p, unit );
+    r.value = unit;
+    for ( unsigned int i=0; i<count; i++ ) roots.push_back( r );
+  }
+
+  std::vector<Complex> found;
+  bool converged = findRoots( p, found );
+  for ( size_t i=0; i<found.size(); i++ ) {
+    r.value = found[i];
+    roots.push_back( r );
+  }
+
+  return converged;
+}
+
+void SosCascade :: factor( std::vector<StkFloat> &bCoefficients, std::vector<StkFloat> &aCoefficients, std::vector<StkFloat> &sections )
+{
+  std::vector<Root> zeros, poles;
+  StkFloat bLeading, aLeading;
+  bool converged = polynomialRoots( bCoefficients, zeros, bLeading, true );
+  converged = polynomialRoots( aCoefficients, poles, aLeading, false ) && converged;
+  if ( !converged ) {
+    oStream_ << "SosCascade::setCoefficients: polynomial roots did not converge, the response may be inaccurate!";
+    handleError( StkError::WARNING );
+  }
+
+  for ( size_t i=0; i<poles.size(); i++ ) {
+    if ( std::abs( poles[i].value ) >= 1.0 ) {
+      oStream_ << "SosCascade::setCoefficients: denominator has a pole on or outside the unit circle, the filter is unstable!";
+      handleError( StkError::WARNING );
+      break;
+    }
+  }
+
+  std::vector<RootGroup> zeroGroups, poleGroups;
+  groupRoots( zeros, zeroGroups );
+  groupRoots( poles, poleGroups );
+
+  RootGroup none;
+  none.count = 0;
+  size_t count = std::max( zeroGroups.size(), poleGroups.size() );
+  if ( count == 0 ) count = 1;
+  while ( poleGroups.size() < count ) poleGroups.push_back( none );
+
+  // Match the most resonant poles first with the nearest zeros, then
+  // order the sections with the most resonant last.
+  std::sort( poleGroups.begin(), poleGroups.end(), lessRadius );
+  std::vector<RootGroup> matched( count, none );
+  std::vector<bool> used( zeroGroups.size(), false );
+  for ( size_t s=count; s-- > 0; ) {
+    const RootGroup &poles = poleGroups[s];
+    size_t best = zeroGroups.size();
+    StkFloat bestDistance = std::numeric_limits<StkFloat>::max();
+    for ( size_t z=0; z<zeroGroups.size(); z++ ) {
+      if ( used[z] ) continue;
+      const Root &zero = zeroGroups[z].roots[0];
+      StkFloat distance = std::numeric_limits<StkFloat>::max() / 2;
+      if ( !zero.infinite && poles.count > 0 ) distance = std::abs( zero.value - poles.roots[0].value );
+      if ( best == zeroGroups.size() || distance < bestDistance ) {
+        best = z;
+        bestDistance = distance;
+      }
+    }
+    if ( best < zeroGroups.size() ) {
+      matched[s] = zeroGroups[best];
+      used[best] = true;
+    }
+  }
+
+  sections.assign( 6 * count, 0.0 );
+  for ( size_t s=0; s<count; s++ ) {
+    expand( matched[s], &sections[6*s] );
+    expand( poleGroups[s], &sections[6*s + 3] );
+  }
+
+  // The overall gain goes in the first section.
+  StkFloat gain = bLeading / aLeading;
+  for ( int i=0; i<3; i++ ) sections[i] *= gain;
+}
+
+} // stk namespace
@@ -0,0 +1,279 @@
+#ifndef STK_SOSCASCADE_H
+#define STK_SOSCASCADE_H
+
+#include "Filter.h"
+
+namespace stk {
+
+/***************************************************/
+/*! \class SosCascade
+    \brief STK cascade of second-order filter sections.
+
+    This class computes the same transfer function as Iir, but as a
+    cascade of second-order sections in transposed direct form II.
+    High-order filters built from a single direct-form polynomial
+    lose precision badly once their poles crowd together (steep or
+    low-frequency designs).  A cascade keeps each section's
+    coefficients well conditioned and costs five multiplies per
+    section per sample.
+
+    setCoefficients() accepts the same b and a vectors as
+    Iir::setCoefficients() and factors them into sections.  Each
+    complex pole pair (or pair of real poles) is matched with the
+    nearest remaining zeros, and sections are ordered with the most
+    resonant last.  Sections can also be given directly with
+    setSections(), which is preferable when a design is available in
+    that form: past a certain order and steepness the polynomial
+    coefficients themselves no longer determine stable poles.
+
+    The filter runs one state per channel.  tickChannels() processes
+    every channel of a frame together, section by section, with the
+    channel loop innermost and contiguous so the compiler can
+    vectorize across channels.  The single-channel tick() functions
+    use the state of channel 0.
+
+    The \e gain parameter is applied at the filter input and does not
+    affect the coefficient values.  The default gain value is 1.0.
+*/
+/***************************************************/
+
+class SosCascade : public Filter
+{
+public:
+  //! Default constructor creates a zero-order pass-through "filter" for \e channels channels.
+  SosCascade( unsigned int channels = 1 );
+
+  //! Overloaded constructor which takes Iir-style filter coefficients.
+  /*!
+    An StkError can be thrown if either of the coefficient vector
+    sizes is zero, or if the a[0] coefficient is equal to zero.
+  */
+  SosCascade( std::vector<StkFloat> &bCoefficients, std::vector<StkFloat> &aCoefficients, unsigned int channels = 1 );
+
+  //! Class destructor.
+  ~SosCascade( void );
+
+  //! Set the filter from Iir-style coefficients, factored into second-order sections.
+  /*!
+    An StkError can be thrown if either of the coefficient vector
+    sizes is zero, or if the a[0] coefficient is equal to zero.  A
+    warning is reported if the polynomial roots do not converge.  The
+    internal state is cleared if the number of sections changes, or
+    if the \e clearState flag is \c true.
+  */
+  void setCoefficients( std::vector<StkFloat> &bCoefficients, std::vector<StkFloat> &aCoefficients, bool clearState = false );
+
+  //! Set the sections directly, as six values per section: b0, b1, b2, a0, a1, a2.
+  /*!
+    Each section is normalized by its a0.  An StkError can be
+    thrown if the vector size is not a non-zero multiple of six, or
+    if any a0 is equal to zero.  The internal state is cleared if the
+    number of sections changes, or if the \e clearState flag is \c
+    true.
+  */
+  void setSections( std::vector<StkFloat> &sections, bool clearState = false );
+
+  //! Return the sections as six values per section, normalized so a0 is 1.
+  std::vector<StkFloat> getSections( void ) const;
+
+  //! Return the number of second-order sections.
+  unsigned int getNumSections( void ) const { return sections_; };
+
+  //! Set the number of channels processed.  The internal state is cleared.
+  void setChannels( unsigned int channels );
+
+  //! Clears all internal states of the filter.
+  void clear( void );
+
+  //! Return the number of bytes the filter has allocated on the heap.
+  size_t heapBytes( void ) const;
+
+  //! Return the last computed output value of \c channel.
+  StkFloat lastOut( unsigned int channel = 0 ) const { return lastFrame_[channel]; };
+
+  //! Input one sample to channel 0 of the filter and return one output.
+  StkFloat tick( StkFloat input );
+
+  //! Take a channel of the StkFrames object as inputs to the filter and replace with corresponding outputs.
+  /*!
+    The StkFrames argument reference is returned.  The filter state
+    of channel 0 is used.  The \c channel argument must be less than
+    the number of channels in the StkFrames argument (the first
+    channel is specified by 0).  However, range checking is only
+    performed if _STK_DEBUG_ is defined during compilation, in which
+    case an out-of-range value will trigger an StkError exception.
+  */
+  StkFrames& tick( StkFrames& frames, unsigned int channel = 0 );
+
+  //! Take a channel of the \c iFrames object as inputs to the filter and write outputs to the \c oFrames object.
+  /*!
+    The \c iFrames object reference is returned.  The filter state
+    of channel 0 is used.  Each channel argument must be less than
+    the number of channels in the corresponding StkFrames argument
+    (the first channel is specified by 0).  However, range checking
+    is only performed if _STK_DEBUG_ is defined during compilation,
+    in which case an out-of-range value will trigger an StkError
+    exception.
+  */
+  StkFrames& tick( StkFrames& iFrames, StkFrames &oFrames, unsigned int iChannel = 0, unsigned int oChannel = 0 );
+
+  //! Filter every channel of the StkFrames object in place, each with its own state.
+  /*!
+    The StkFrames argument reference is returned.  It must have the
+    number of channels set with setChannels().  However, range
+    checking is only performed if _STK_DEBUG_ is defined during
+    compilation, in which case a mismatch will trigger an StkError
+    exception.
+  */
+  StkFrames& tickChannels( StkFrames& frames );
+
+  //! Filter every channel of the StkFrameView in place, each with its own state.
+  /*!
+    The StkFrameView argument reference is returned.  It must have
+    the number of channels set with setChannels().  However, range
+    checking is only performed if _STK_DEBUG_ is defined during
+    compilation, in which case a mismatch will trigger an StkError
+    exception.
+  */
+  StkFrameView& tickChannels( StkFrameView& frames );
+
+protected:
+
+  StkFloat tickSections( StkFloat input );
+  void tickLanes( StkFloat *lanes );
+  void factor( std::vector<StkFloat> &bCoefficients, std::vector<StkFloat> &aCoefficients, std::vector<StkFloat> &sections );
+
+  unsigned int sections_;
+  unsigned int channels_;
+
+  // b0, b1, b2, a1, a2 of each section, normalized by a0
+  std::vector<StkFloat> coefficients_;
+
+  // transposed direct form II state, section-major with one lane per channel
+  std::vector<StkFloat> z1_;
+  std::vector<StkFloat> z2_;
+
+  // one frame of channel samples, for planar input
+  std::vector<StkFloat> lanes_;
+};
+
+inline StkFloat SosCascade :: tickSections( StkFloat input )
+{
+  const StkFloat *c = &coefficients_[0];
+  unsigned int hop = channels_;
+  StkFloat x = input, y;
+  for ( unsigned int s=0, k=0; s<sections_; s++, c += 5, k += hop ) {
+    y = c[0] * x + z1_[k];
+    z1_[k] = c[1] * x - c[3] * y + z2_[k];
+    z2_[k] = c[2] * x - c[4] * y;
+    x = y;
+  }
+
+  return x;
+}
+
+inline void SosCascade :: tickLanes( StkFloat *lanes )
+{
+  const StkFloat *c = &coefficients_[0];
+  unsigned int n = channels_;
+  for ( unsigned int i=0; i<n; i++ ) lanes[i] *= gain_;
+
+  for ( unsigned int s=0; s<sections_; s++, c += 5 ) {
+    StkFloat b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+    StkFloat *z1 = &z1_[s * n];
+    StkFloat *z2 = &z2_[s * n];
+    for ( unsigned int i=0; i<n; i++ ) {
+      StkFloat x = lanes[i];
+      StkFloat y = b0 * x + z1[i];
+      z1[i] = b1 * x - a1 * y + z2[i];
+      z2[i] = b2 * x - a2 * y;
+      lanes[i] = y;
+    }
+  }
+
+  for ( unsigned int i=0; i<n; i++ ) lastFrame_[i] = lanes[i];
+}
+
+inline StkFloat SosCascade :: tick( StkFloat input )
+{
+  lastFrame_[0] = tickSections( gain_ * input );
+  return lastFrame_[0];
+}
+
+inline StkFrames& SosCascade :: tick( StkFrames& frames, unsigned int channel )
+{
+#if defined(_STK_DEBUG_)
+  if ( channel >= frames.channels() ) {
+    oStream_ << "SosCascade::tick(): channel and StkFrames arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  StkFloat *samples = &frames[channel];
+  unsigned int hop = frames.channels();
+  for ( unsigned int i=0; i<frames.frames(); i++, samples += hop )
+    *samples = tickSections( gain_ * *samples );
+
+  if ( frames.frames() > 0 ) lastFrame_[0] = *(samples-hop);
+  return frames;
+}
+
+inline StkFrames& SosCascade :: tick( StkFrames& iFrames, StkFrames& oFrames, unsigned int iChannel, unsigned int oChannel )
+{
+#if defined(_STK_DEBUG_)
+  if ( iChannel >= iFrames.channels() || oChannel >= oFrames.channels() ) {
+    oStream_ << "SosCascade::tick(): channel and StkFrames arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  StkFloat *iSamples = &iFrames[iChannel];
+  StkFloat *oSamples = &oFrames[oChannel];
+  unsigned int iHop = iFrames.channels(), oHop = oFrames.channels();
+  for ( unsigned int i=0; i<iFrames.frames(); i++, iSamples += iHop, oSamples += oHop )
+    *oSamples = tickSections( gain_ * *iSamples );
+
+  if ( iFrames.frames() > 0 ) lastFrame_[0] = *(oSamples-oHop);
+  return iFrames;
+}
+
+inline StkFrames& SosCascade :: tickChannels( StkFrames& frames )
+{
+#if defined(_STK_DEBUG_)
+  if ( frames.channels() != channels_ ) {
+    oStream_ << "SosCascade::tickChannels(): StkFrames argument and filter channels are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  // Interleaved frames are already one contiguous lane per channel.
+  StkFloat *samples = &frames[0];
+  for ( unsigned int i=0; i<frames.frames(); i++, samples += channels_ )
+    tickLanes( samples );
+
+  return frames;
+}
+
+inline StkFrameView& SosCascade :: tickChannels( StkFrameView& frames )
+{
+#if defined(_STK_DEBUG_)
+  if ( frames.channels() != channels_ ) {
+    oStream_ << "SosCascade::tickChannels(): StkFrameView argument and filter channels are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  StkFloat *lanes = &lanes_[0];
+  unsigned int c, hop = frames.stride();
+  for ( unsigned int i=0; i<frames.frames(); i++ ) {
+    for ( c=0; c<channels_; c++ ) lanes[c] = frames.channel( c )[i * hop];
+    tickLanes( lanes );
+    for ( c=0; c<channels_; c++ ) frames.channel( c )[i * hop] = (float) lanes[c];
+  }
+
+  return frames;
+}
+
+} // stk namespace
+
+#endif
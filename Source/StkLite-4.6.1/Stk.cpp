@@ -66,10 +66,10 @@ const Stk::StkFormat Stk :: STK_FLOAT64 = 0x20;
 bool Stk :: showWarnings_ = true;
 bool Stk :: printErrors_ = true;
 std::vector<Stk *> Stk :: alertList_;
-std::ostringstream Stk :: oStream_;
+thread_local std::ostringstream Stk :: oStream_;
 
 Stk :: Stk( void )
-  : ignoreSampleRateChange_(false)
+  : ignoreSampleRateChange_(false), context_(0)
 {
 }
 
@@ -95,8 +95,29 @@ void Stk :: sampleRateChanged( StkFloat /*newRate*/, StkFloat /*oldRate*/ )
   // rate change.
 }
 
+void Stk :: setContext( StkContext *context )
+{
+  if ( context == context_ ) return;
+
+  bool alerted = false;
+  if ( context_ ) alerted = context_->hasSampleRateAlert( this );
+  else {
+    for ( unsigned int i=0; i<alertList_.size(); i++ )
+      if ( alertList_[i] == this ) alerted = true;
+  }
+
+  if ( alerted ) removeSampleRateAlert( this );
+  context_ = context;
+  if ( alerted ) addSampleRateAlert( this );
+}
+
 void Stk :: addSampleRateAlert( Stk *ptr )
 {
+  if ( context_ ) {
+    context_->addSampleRateAlert( ptr );
+    return;
+  }
+
   for ( unsigned int i=0; i<alertList_.size(); i++ )
     if ( alertList_[i] == ptr ) return;
 
@@ -105,6 +126,11 @@ void Stk :: addSampleRateAlert( Stk *ptr )
 
 void Stk :: removeSampleRateAlert( Stk *ptr )
 {
+  if ( context_ ) {
+    context_->removeSampleRateAlert( ptr );
+    return;
+  }
+
   for ( unsigned int i=0; i<alertList_.size(); i++ ) {
     if ( alertList_[i] == ptr ) {
       alertList_.erase( alertList_.begin() + i );
@@ -194,8 +220,11 @@ void Stk :: sleep(unsigned long milliseconds)
 
 void Stk :: handleError( StkError::Type type ) const
 {
-  handleError( oStream_.str(), type );
-  oStream_.str( std::string() ); // reset the ostringstream buffer
+  std::string message = oStream_.str();
+  oStream_.str( std::string() ); // reset the ostringstream buffer before anything can throw
+
+  if ( context_ ) context_->handleError( message, type );
+  else handleError( message, type );
 }
 
 void Stk :: handleError( const char *message, StkError::Type type )
@@ -224,6 +253,71 @@ void Stk :: handleError( std::string message, StkError::Type type )
   }
 }
 
+//
+// StkContext definitions
+//
+
+StkContext :: StkContext( StkFloat rate )
+  : srate_( rate ), errorCallback_( 0 ), errorUserData_( 0 )
+{
+}
+
+StkContext :: ~StkContext()
+{
+}
+
+void StkContext :: setSampleRate( StkFloat rate )
+{
+  if ( rate > 0.0 && rate != srate_ ) {
+    StkFloat oldRate = srate_;
+    srate_ = rate;
+
+    for ( unsigned int i=0; i<alertList_.size(); i++ )
+      alertList_[i]->sampleRateChanged( srate_, oldRate );
+  }
+}
+
+void StkContext :: setErrorCallback( ErrorCallback callback, void *userData )
+{
+  errorCallback_ = callback;
+  errorUserData_ = userData;
+}
+
+void StkContext :: handleError( const std::string& message, StkError::Type type )
+{
+  if ( !errorCallback_ ) {
+    Stk::handleError( message, type );
+    return;
+  }
+
+  errorCallback_( message, type, errorUserData_ );
+  if ( type != StkError::WARNING && type != StkError::STATUS && type != StkError::DEBUG_PRINT )
+    throw StkError( message, type );
+}
+
+void StkContext :: addSampleRateAlert( Stk *ptr )
+{
+  if ( !hasSampleRateAlert( ptr ) )
+    alertList_.push_back( ptr );
+}
+
+void StkContext :: removeSampleRateAlert( Stk *ptr )
+{
+  for ( unsigned int i=0; i<alertList_.size(); i++ ) {
+    if ( alertList_[i] == ptr ) {
+      alertList_.erase( alertList_.begin() + i );
+      return;
+    }
+  }
+}
+
+bool StkContext :: hasSampleRateAlert( Stk *ptr ) const
+{
+  for ( unsigned int i=0; i<alertList_.size(); i++ )
+    if ( alertList_[i] == ptr ) return true;
+  return false;
+}
+
 //
 // StkFrames definitions
 //
@@ -129,6 +129,75 @@ public:
 };
 
 
+class Stk;
+
+/***************************************************/
+/*! \class StkContext
+    \brief Per-engine STK sample rate and error handling.
+
+    Stk keeps its sample rate, sample rate listeners and error
+    reporting in process-wide statics, which independent plugin
+    instances running on different audio threads (possibly at
+    different rates) would share.  An StkContext holds the same state
+    for one engine.  Objects attached to a context with
+    Stk::setContext() read its sample rate, register their sample
+    rate alerts with it and report errors through its sink instead of
+    the globals.
+
+    A context is not itself thread-safe; it is meant to be owned and
+    used by a single engine.
+*/
+/***************************************************/
+
+class StkContext
+{
+public:
+
+  //! Error sink called with each message reported by attached objects.
+  typedef void (*ErrorCallback)( const std::string& message, StkError::Type type, void *userData );
+
+  //! Create a context running at \e rate Hz.
+  StkContext( StkFloat rate = 44100.0 );
+
+  //! Class destructor.
+  ~StkContext();
+
+  //! Return the context sample rate.
+  StkFloat sampleRate( void ) const { return srate_; };
+
+  //! Set the context sample rate and notify attached objects that registered for alerts.
+  void setSampleRate( StkFloat rate );
+
+  //! Route reported errors to \e callback instead of printing them.
+  /*!
+    WARNING, STATUS and DEBUG_PRINT messages are only passed to the
+    callback.  Other error types are passed to the callback and then
+    thrown as an StkError, as they are without a context.  Passing a
+    null callback restores the default printing behaviour.
+   */
+  void setErrorCallback( ErrorCallback callback, void *userData = 0 );
+
+  //! Report an error through the context sink.
+  void handleError( const std::string& message, StkError::Type type );
+
+  //! Add an object to the sample rate change notification list.
+  void addSampleRateAlert( Stk *ptr );
+
+  //! Remove an object from the sample rate change notification list.
+  void removeSampleRateAlert( Stk *ptr );
+
+  //! Return true if \e ptr is on the sample rate change notification list.
+  bool hasSampleRateAlert( Stk *ptr ) const;
+
+private:
+
+  StkFloat srate_;
+  std::vector<Stk *> alertList_;
+  ErrorCallback errorCallback_;
+  void *errorUserData_;
+};
+
+
 class Stk
 {
 public:
@@ -164,6 +233,21 @@ public:
   */
   static void setSampleRate( StkFloat rate );
 
+  //! Attach this object to a per-engine context, or to the globals if \e context is null.
+  /*!
+    The object then uses the context sample rate and error sink.  If
+    the object was registered for sample rate alerts, the
+    registration moves to the new context.  The context must outlive
+    the object or be detached first.
+  */
+  void setContext( StkContext *context );
+
+  //! Return the context this object is attached to, or null.
+  StkContext *getContext( void ) const { return context_; };
+
+  //! Return the sample rate of the attached context, or the global STK sample rate.
+  StkFloat contextSampleRate( void ) const { return context_ ? context_->sampleRate() : srate_; };
+
   //! A function to enable/disable the automatic updating of class data when the STK sample rate changes.
   /*!
     This function allows the user to enable or disable class data
@@ -213,6 +297,8 @@ public:
   static void printErrors( bool status ) { printErrors_ = status; }
 
 private:
+  friend class StkContext;
+
   static StkFloat srate_;
   static std::string rawwavepath_;
   static bool showWarnings_;
@@ -221,8 +307,11 @@ private:
 
 protected:
 
-  static std::ostringstream oStream_;
+  // One message stream per thread, so objects reporting from different
+  // audio threads don't interleave or race on a shared buffer.
+  static thread_local std::ostringstream oStream_;
   bool ignoreSampleRateChange_;
+  StkContext *context_;
 
   //! Default constructor.
   Stk( void );
@@ -233,13 +322,17 @@ protected:
   //! This function should be implemented in subclasses that depend on the sample rate.
   virtual void sampleRateChanged( StkFloat newRate, StkFloat oldRate );
 
-  //! Add class pointer to list for sample rate change notification.
+  //! Add class pointer to list for sample rate change notification (the context's list if attached).
   void addSampleRateAlert( Stk *ptr );
 
   //! Remove class pointer from list for sample rate change notification.
   void removeSampleRateAlert( Stk *ptr );
 
   //! Internal function for error reporting that assumes message in \c oStream_ variable.
+  /*!
+    The message goes to the attached context's error sink if there is
+    one, and to the static handleError() otherwise.
+   */
   void handleError( StkError::Type type ) const;
 };
 
@@ -331,6 +424,28 @@ public:
   */
   void operator*= ( StkFrames& f );
 
+  //! Multiply every element of self by \c gain.
+  StkFrames& scale( StkFloat gain );
+
+  //! Add \c f scaled by \c gain into self in one pass.
+  /*!
+    Equivalent to self += f * gain, without the temporary that
+    operator+ would allocate.  The dimensions of the argument are
+    expected to be the same as self.  No range checking is performed
+    unless _STK_DEBUG_ is defined.
+  */
+  StkFrames& addScaled( const StkFrames& f, StkFloat gain );
+
+  //! Set self to \c a * \c aGain + \c b * \c bGain in one pass.
+  /*!
+    This is the fused form of a wet/dry mix.  Self may be \c a or
+    \c b.  Self is resized to the dimensions of \c a, which only
+    allocates if it is larger than the current capacity, and \c b is
+    expected to have the same dimensions.  No range checking is
+    performed unless _STK_DEBUG_ is defined.
+  */
+  StkFrames& mix( const StkFrames& a, StkFloat aGain, const StkFrames& b, StkFloat bGain );
+
   //! Channel / frame subscript operator that returns a reference.
   /*!
     The result can be used as an lvalue. This reference is valid
@@ -361,6 +476,9 @@ public:
   //! Returns the total number of audio samples represented by the object.
   size_t size() const { return size_; }; 
 
+  //! Returns the number of audio samples allocated, which may exceed size() after a shrinking resize.
+  size_t capacity() const { return bufferSize_; };
+
   //! Returns \e true if the object size is zero and \e false otherwise.
   bool empty() const;
 
@@ -540,6 +658,145 @@ inline void StkFrames :: operator*= ( StkFrames& f )
     *dptr++ *= *fptr++;
 }
 
+/***************************************************/
+/*! \class StkFrameView
+    \brief Non-owning view of float sample frames.
+
+    StkFrameView lets the block tick() functions of filters and delay
+    lines run directly on host float buffers, without copying them
+    into an interleaved StkFrames object.  The view either refers to
+    an array of planar channel pointers (e.g. the result of
+    juce::AudioBuffer<float>::getArrayOfWritePointers()) or to a
+    single block of samples with a fixed frame stride (e.g. one
+    getWritePointer() channel, or interleaved data), and is created
+    with mono(), planar() or interleaved().
+
+    No memory is allocated or copied.  The view is valid only as
+    long as the memory it refers to.
+*/
+/***************************************************/
+
+class StkFrameView
+{
+public:
+
+  //! Create an empty view.
+  StkFrameView( void )
+    : channels_(0), base_(0), nFrames_(0), nChannels_(0), stride_(1) {};
+
+  //! View \e nFrames samples of a single channel, e.g. from getWritePointer().
+  static StkFrameView mono( float *data, unsigned int nFrames )
+  {
+    return StkFrameView( 0, data, nFrames, 1, 1 );
+  };
+
+  //! View \e nChannels planar channels of \e nFrames samples each.
+  /*!
+    The \e channels array itself is referenced, not copied.
+   */
+  static StkFrameView planar( float *const *channels, unsigned int nFrames, unsigned int nChannels )
+  {
+    return StkFrameView( channels, 0, nFrames, nChannels, 1 );
+  };
+
+  //! View \e nFrames interleaved frames of \e nChannels samples each.
+  static StkFrameView interleaved( float *data, unsigned int nFrames, unsigned int nChannels )
+  {
+    return StkFrameView( 0, data, nFrames, nChannels, nChannels );
+  };
+
+  //! Return a pointer to the first sample of \e channel.
+  float *channel( unsigned int channel ) const { return channels_ ? channels_[channel] : base_ + channel; };
+
+  //! Return the distance between consecutive samples of a channel.
+  unsigned int stride( void ) const { return stride_; };
+
+  //! Channel / frame subscript operator that returns a reference.
+  /*!
+    The \c frame index must be between 0 and frames() - 1.  The \c
+    channel index must be between 0 and channels() - 1.  No range
+    checking is performed unless _STK_DEBUG_ is defined.
+  */
+  float& operator() ( size_t frame, unsigned int channel ) const;
+
+  //! Return the number of channels represented by the view.
+  unsigned int channels( void ) const { return nChannels_; };
+
+  //! Return the number of sample frames represented by the view.
+  unsigned int frames( void ) const { return nFrames_; };
+
+private:
+
+  // The layouts share argument types, so they are built through the
+  // named functions above, which all take frames before channels.
+  StkFrameView( float *const *channels, float *base, unsigned int nFrames, unsigned int nChannels, unsigned int stride )
+    : channels_(channels), base_(base), nFrames_(nFrames), nChannels_(nChannels), stride_(stride) {};
+
+  float *const *channels_;
+  float *base_;
+  unsigned int nFrames_;
+  unsigned int nChannels_;
+  unsigned int stride_;
+};
+
+inline float& StkFrameView :: operator() ( size_t frame, unsigned int channel ) const
+{
+#if defined(_STK_DEBUG_)
+  if ( frame >= nFrames_ || channel >= nChannels_ ) {
+    std::ostringstream error;
+    error << "StkFrameView::operator(): invalid frame (" << frame << ") or channel (" << channel << ") value!";
+    Stk::handleError( error.str(), StkError::MEMORY_ACCESS );
+  }
+#endif
+
+  return this->channel( channel )[ frame * stride_ ];
+}
+
+inline StkFrames& StkFrames :: scale( StkFloat gain )
+{
+  StkFloat *dptr = data_;
+  for ( size_t i=0; i<size_; i++ )
+    dptr[i] *= gain;
+  return *this;
+}
+
+inline StkFrames& StkFrames :: addScaled( const StkFrames& f, StkFloat gain )
+{
+#if defined(_STK_DEBUG_)
+  if ( f.frames() != nFrames_ || f.channels() != nChannels_ ) {
+    std::ostringstream error;
+    error << "StkFrames::addScaled: frames argument must be of equal dimensions!";
+    Stk::handleError( error.str(), StkError::MEMORY_ACCESS );
+  }
+#endif
+
+  const StkFloat *fptr = f.data_;
+  StkFloat *dptr = data_;
+  for ( size_t i=0; i<size_; i++ )
+    dptr[i] += fptr[i] * gain;
+  return *this;
+}
+
+inline StkFrames& StkFrames :: mix( const StkFrames& a, StkFloat aGain, const StkFrames& b, StkFloat bGain )
+{
+#if defined(_STK_DEBUG_)
+  if ( b.frames() != a.frames() || b.channels() != a.channels() ) {
+    std::ostringstream error;
+    error << "StkFrames::mix: frames arguments must be of equal dimensions!";
+    Stk::handleError( error.str(), StkError::MEMORY_ACCESS );
+  }
+#endif
+
+  if ( this != &a ) this->resize( a.nFrames_, a.nChannels_ );
+
+  const StkFloat *aptr = a.data_;
+  const StkFloat *bptr = b.data_;
+  StkFloat *dptr = data_;
+  for ( size_t i=0; i<size_; i++ )
+    dptr[i] = aptr[i] * aGain + bptr[i] * bGain;
+  return *this;
+}
+
 // Here are a few other useful typedefs.
 typedef unsigned short UINT16;
 typedef unsigned int UINT32;
@@ -19,6 +19,7 @@
 namespace stk {
 
 TapDelay :: TapDelay( std::vector<unsigned long> taps, unsigned long maxDelay )
+  : buffer_( 0, true )
 {
   // Writing before reading allows delays from 0 to length-1. 
   // If we want to allow a delay of maxDelay, we need a
@@ -35,8 +36,10 @@ TapDelay :: TapDelay( std::vector<unsigned long> taps, unsigned long maxDelay )
     }
   }
 
-  if ( ( maxDelay + 1 ) > inputs_.size() )
-    inputs_.resize( maxDelay + 1, 1, 0.0 );
+  // Block reads need room for one chunk of input plus the
+  // interpolation neighbour of the longest delay.
+  buffer_.resize( maxDelay + 1 + BLOCK_CHUNK );
+  maxDelay_ = maxDelay;
 
   inPoint_ = 0;
   this->setTapDelays( taps );
@@ -46,9 +49,16 @@ TapDelay :: ~TapDelay()
 {
 }
 
+void TapDelay :: clear( void )
+{
+  buffer_.clear();
+  for ( unsigned int i=0; i<lastFrame_.size(); i++ )
+    lastFrame_[i] = 0.0;
+}
+
 void TapDelay :: setMaximumDelay( unsigned long delay )
 {
-  if ( delay < inputs_.size() ) return;
+  if ( delay <= maxDelay_ ) return;
 
   for ( unsigned int i=0; i<delays_.size(); i++ ) {
     if ( delay < delays_[i] ) {
@@ -57,13 +67,16 @@ void TapDelay :: setMaximumDelay( unsigned long delay )
     }
   }
 
-  inputs_.resize( delay + 1 );
+  buffer_.resize( delay + 1 + BLOCK_CHUNK );
+  maxDelay_ = delay;
+  inPoint_ &= buffer_.mask();
+  this->setTapDelays( delays_ );
 }
 
 void TapDelay :: setTapDelays( std::vector<unsigned long> taps )
 {
   for ( unsigned int i=0; i<taps.size(); i++ ) {
-    if ( taps[i] > inputs_.size() - 1 ) { // The value is too big.
+    if ( taps[i] > maxDelay_ ) { // The value is too big.
       oStream_ << "TapDelay::setTapDelay: argument (" << taps[i] << ") greater than maximum!\n";
       handleError( StkError::WARNING ); return;
     }
@@ -77,11 +90,54 @@ void TapDelay :: setTapDelays( std::vector<unsigned long> taps )
 
   for ( unsigned int i=0; i<taps.size(); i++ ) {
     // read chases write
-    if ( inPoint_ >= taps[i] ) outPoint_[i] = inPoint_ - taps[i];
-    else outPoint_[i] = inputs_.size() + inPoint_ - taps[i];
+    outPoint_[i] = ( inPoint_ - taps[i] ) & buffer_.mask();
     delays_[i] = taps[i];
   }
 }
 
+void TapDelay :: tickTaps( const float *input, unsigned long nFrames, const float *const *delays, float *const *outputs, unsigned int nTaps )
+{
+  const StkFloat maxDelay = (StkFloat) maxDelay_;
+  const unsigned long mask = buffer_.mask();
+  unsigned long start = 0;
+
+  while ( start < nFrames ) {
+    unsigned long count = nFrames - start;
+    if ( count > BLOCK_CHUNK ) count = BLOCK_CHUNK;
+
+    // Write the whole chunk first, so each tap reads it in one pass.
+    for ( unsigned long i=0; i<count; i++ ) {
+      buffer_.set( inPoint_, input[start + i] * gain_ );
+      inPoint_ = ( inPoint_ + 1 ) & mask;
+    }
+
+    // The mirrored buffer holds the newest count + maxDelay_ + 1
+    // samples contiguously, oldest first.  Frame i with delay 0 is at
+    // window[maxDelay_ + 1 + i].
+    unsigned long length = count + maxDelay_ + 1;
+    const StkFloat *window = buffer_.data() + ( ( inPoint_ - length ) & mask ) + maxDelay_ + 1;
+
+    for ( unsigned int t=0; t<nTaps; t++ ) {
+      const float *delay = delays[t] + start;
+      float *out = outputs[t] + start;
+      for ( unsigned long i=0; i<count; i++ ) {
+        StkFloat d = delay[i];
+        if ( d < 0.0 ) d = 0.0;
+        else if ( d > maxDelay ) d = maxDelay;
+        long n = (long) d;
+        StkFloat alpha = d - n;
+        const StkFloat *x = window + i - n;
+        out[i] = (float) ( x[0] + alpha * ( x[-1] - x[0] ) );
+      }
+    }
+
+    start += count;
+  }
+
+  // Keep the integer taps at their delays behind the input.
+  for ( unsigned int j=0; j<outPoint_.size(); j++ )
+    outPoint_[j] = ( inPoint_ - delays_[j] ) & mask;
+}
+
 } // stk namespace
 
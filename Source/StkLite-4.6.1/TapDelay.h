@@ -2,6 +2,7 @@
 #define STK_TAPDELAY_H
 
 #include "Filter.h"
+#include "RingBuffer.h"
 
 namespace stk {
 
@@ -17,6 +18,13 @@ namespace stk {
     A non-interpolating delay line is typically used in fixed
     delay-length applications, such as for reverberation.
 
+    tickTaps() reads any number of linearly interpolated taps, each
+    with its own per-sample delay, from the same history.  A block of
+    input is written once and every tap is then read as one loop over
+    the block, which suits modulated multi-voice effects such as a
+    chorus ensemble.  The history is held in a mirrored RingBuffer,
+    so these reads never wrap.
+
     by Perry R. Cook and Gary P. Scavone, 1995--2019.
 */
 /***************************************************/
@@ -55,6 +63,15 @@ class TapDelay : public Filter
   //! Return the current delay-line length.
   std::vector<unsigned long> getTapDelays( void ) const { return delays_; };
 
+  //! Return the maximum delay-line length.
+  unsigned long getMaximumDelay( void ) const { return maxDelay_; };
+
+  //! Clears all internal states of the delay line.
+  void clear( void );
+
+  //! Return the number of bytes the delay line has allocated on the heap.
+  size_t heapBytes( void ) const { return Filter::heapBytes() + buffer_.heapBytes(); };
+
   //! Return the specified tap value of the last computed frame.
   /*!
     Use the lastFrame() function to get all tap values from the
@@ -104,8 +121,46 @@ class TapDelay : public Filter
   */
   StkFrames& tick( StkFrames& iFrames, StkFrames &oFrames, unsigned int iChannel = 0 );
 
+  //! Take a channel of the StkFrameView as inputs to the delayline and write tap outputs back to the same view.
+  /*!
+    The StkFrameView argument reference is returned.  This works as
+    the StkFrames version, but on float data in place, for example
+    the channels of a host audio buffer.  Tap \e n is written to
+    channel \e n, so the view must contain at least as many channels
+    as the number of taps.  However, range checking is only
+    performed if _STK_DEBUG_ is defined during compilation, in which
+    case an out-of-range value will trigger an StkError exception.
+  */
+  StkFrameView& tick( StkFrameView& frames, unsigned int channel = 0 );
+
+  //! Take a channel of the \c iFrames view as inputs to the delayline and write tap outputs to the \c oFrames view.
+  /*!
+    The \c iFrames view reference is returned.  Tap \e n is written
+    to channel \e n of \c oFrames, which must contain at least as many
+    channels as the number of taps.  However, range checking is only
+    performed if _STK_DEBUG_ is defined during compilation, in which
+    case an out-of-range value will trigger an StkError exception.
+  */
+  StkFrameView& tick( StkFrameView& iFrames, StkFrameView &oFrames, unsigned int iChannel = 0 );
+
+  //! Input a block of samples and write \e nTaps fractional, per-sample modulated taps to planar outputs.
+  /*!
+    For each tap \e t and frame \e i, \c outputs[t][i] is the input
+    delayed by \c delays[t][i] samples, linearly interpolated.  Delays
+    are clamped to the range 0 to the maximum delay-line length.  The
+    taps are independent of those set with setTapDelays(), which keep
+    their positions relative to the input, and lastOut() is not
+    updated.  The \c input array may also be one of the outputs.
+  */
+  void tickTaps( const float *input, unsigned long nFrames, const float *const *delays, float *const *outputs, unsigned int nTaps );
+
  protected:
 
+  // Block reads write at most this many samples ahead of the taps.
+  static const unsigned long BLOCK_CHUNK = 64;
+
+  RingBuffer buffer_;
+  unsigned long maxDelay_;
   unsigned long inPoint_;
   std::vector<unsigned long> outPoint_;
   std::vector<unsigned long> delays_;
@@ -133,19 +188,17 @@ inline StkFrames& TapDelay :: tick( StkFloat input, StkFrames& outputs )
   }
 #endif
 
-  inputs_[inPoint_++] = input * gain_;
+  buffer_.set( inPoint_, input * gain_ );
 
-  // Check for end condition
-  if ( inPoint_ == inputs_.size() )
-    inPoint_ = 0;
+  // Increment input pointer modulo length.
+  inPoint_ = ( inPoint_ + 1 ) & buffer_.mask();
 
   // Read out next values
   StkFloat *outs = &outputs[0];
   for ( unsigned int i=0; i<outPoint_.size(); i++ ) {
-    *outs++ = inputs_[outPoint_[i]];
-    lastFrame_[i] = *outs;
-    if ( ++outPoint_[i] == inputs_.size() )
-      outPoint_[i] = 0;
+    *outs = buffer_[outPoint_[i]];
+    lastFrame_[i] = *outs++;
+    outPoint_[i] = ( outPoint_[i] + 1 ) & buffer_.mask();
   }
 
   return outputs;
@@ -170,11 +223,11 @@ inline StkFrames& TapDelay :: tick( StkFrames& frames, unsigned int channel )
   unsigned int iHop = frames.channels();
   std::size_t oHop = frames.channels() - outPoint_.size();
   for ( unsigned long i=0; i<frames.frames(); i++, iSamples += iHop, oSamples += oHop ) {
-    inputs_[inPoint_++] = *iSamples * gain_;
-    if ( inPoint_ == inputs_.size() ) inPoint_ = 0;
+    buffer_.set( inPoint_, *iSamples * gain_ );
+    inPoint_ = ( inPoint_ + 1 ) & buffer_.mask();
     for ( j=0; j<outPoint_.size(); j++ ) {
-      *oSamples++ = inputs_[outPoint_[j]];
-      if ( ++outPoint_[j] == inputs_.size() ) outPoint_[j] = 0;
+      *oSamples++ = buffer_[outPoint_[j]];
+      outPoint_[j] = ( outPoint_[j] + 1 ) & buffer_.mask();
     }
   }
 
@@ -202,11 +255,11 @@ inline StkFrames& TapDelay :: tick( StkFrames& iFrames, StkFrames& oFrames, unsi
   unsigned int iHop = iFrames.channels();
   std::size_t oHop = oFrames.channels() - outPoint_.size();
   for ( unsigned long i=0; i<iFrames.frames(); i++, iSamples += iHop, oSamples += oHop ) {
-    inputs_[inPoint_++] = *iSamples * gain_;
-    if ( inPoint_ == inputs_.size() ) inPoint_ = 0;
+    buffer_.set( inPoint_, *iSamples * gain_ );
+    inPoint_ = ( inPoint_ + 1 ) & buffer_.mask();
     for ( j=0; j<outPoint_.size(); j++ ) {
-      *oSamples++ = inputs_[outPoint_[j]];
-      if ( ++outPoint_[j] == inputs_.size() ) outPoint_[j] = 0;
+      *oSamples++ = buffer_[outPoint_[j]];
+      outPoint_[j] = ( outPoint_[j] + 1 ) & buffer_.mask();
     }
   }
 
@@ -215,6 +268,45 @@ inline StkFrames& TapDelay :: tick( StkFrames& iFrames, StkFrames& oFrames, unsi
   return iFrames;
 }
 
+inline StkFrameView& TapDelay :: tick( StkFrameView& frames, unsigned int channel )
+{
+  return tick( frames, frames, channel );
+}
+
+inline StkFrameView& TapDelay :: tick( StkFrameView& iFrames, StkFrameView& oFrames, unsigned int iChannel )
+{
+#if defined(_STK_DEBUG_)
+  if ( iChannel >= iFrames.channels() ) {
+    oStream_ << "TapDelay::tick(): channel and StkFrameView arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+  if ( oFrames.channels() < outPoint_.size() ) {
+    oStream_ << "TapDelay::tick(): number of taps > channels in output StkFrameView argument!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  // Each input sample is read before the taps of the same frame are
+  // written, so the input channel may also be an output channel.
+  float *iSamples = iFrames.channel( iChannel );
+  unsigned int iHop = iFrames.stride(), oHop = oFrames.stride();
+  std::size_t j, offset = 0;
+  for ( unsigned long i=0; i<iFrames.frames(); i++, iSamples += iHop, offset += oHop ) {
+    buffer_.set( inPoint_, *iSamples * gain_ );
+    inPoint_ = ( inPoint_ + 1 ) & buffer_.mask();
+    for ( j=0; j<outPoint_.size(); j++ ) {
+      oFrames.channel( (unsigned int) j )[offset] = (float) buffer_[outPoint_[j]];
+      outPoint_[j] = ( outPoint_[j] + 1 ) & buffer_.mask();
+    }
+  }
+
+  if ( iFrames.frames() > 0 ) {
+    offset -= oHop;
+    for ( j=0; j<outPoint_.size(); j++ ) lastFrame_[j] = oFrames.channel( (unsigned int) j )[offset];
+  }
+  return iFrames;
+}
+
 } // stk namespace
 
 #endif